@@ -1,5 +1,6 @@
 #include <array>
 #include <cmath>
+#include <filesystem>
 #include <format>
 #include <random>
 #include <ranges>
@@ -191,7 +192,8 @@ int main()
             std::mem_fn(setup.learn)(
                 learner,
                 parameters,
-                Ticker<TICK_RATE>{[&] { bar.tick(); }})};
+                Ticker<TICK_RATE>{[&] { bar.tick(); }},
+                std::filesystem::path{})};
 
         auto hPlot{matplot::semilogx(parameters, score)};
 
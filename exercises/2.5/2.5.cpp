@@ -1,4 +1,5 @@
 #include <array>
+#include <filesystem>
 #include <format>
 #include <functional>
 #include <random>
@@ -63,6 +64,7 @@ using Result = RewardsAndOptimality;
 struct ExperimentSetup
 {
     std::string title;
+    std::filesystem::path resultsPath;
 
     using LearnFunction =
         decltype(&Bandits::learn<EpsilonGreedyAverage, Stationary, Result>);
@@ -73,15 +75,19 @@ struct ExperimentSetup
 const auto SETUPS{std::to_array<ExperimentSetup>({
     {
         "1/N step",
+        "2.5-average.cols",
         &Bandits::learn<EpsilonGreedyAverage, Stationary, Result>
     }, {
         std::format("{} step", ALPHA),
+        "2.5-constant.cols",
         &Bandits::learn<EpsilonGreedy<ALPHA>, Stationary, Result>
     }, {
         "Walk, 1/N step",
+        "2.5-walk-average.cols",
         &Bandits::learn<EpsilonGreedyAverage, Walking<WALK_SIZE>, Result>
     }, {
         std::format("Walk, {} step", ALPHA),
+        "2.5-walk-constant.cols",
         &Bandits::learn<EpsilonGreedy<ALPHA>, Walking<WALK_SIZE>, Result>
     }})};
 
@@ -121,7 +127,8 @@ int main()
             std::mem_fn(setup.learn)(
                 learner,
                 EPSILONS | std::ranges::to<std::vector<float>>(),
-                Ticker<PROGRESS_FREQ>{[&] { bar.tick(); }})};
+                Ticker<PROGRESS_FREQ>{[&] { bar.tick(); }},
+                setup.resultsPath)};
 
         plotter.plot(setup.title, score.rewards, score.optimality);
     }
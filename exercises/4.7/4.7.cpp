@@ -1,8 +1,14 @@
+#include <algorithm>
 #include <array>
+#include <filesystem>
+#include <format>
 #include <functional>
 #include <limits>
+#include <print>
 #include <random>
 #include <ranges>
+#include <stdexcept>
+#include <utility>
 
 #include <arrayfire.h>
 #include <indicators/color.hpp>
@@ -15,6 +21,8 @@
 #include "introRL/types.hpp"
 #include "introRL/cartesian.hpp"
 #include "introRL/iteration/algorithm.hpp"
+#include "introRL/iteration/asyncSubplotter.hpp"
+#include "introRL/iteration/model.hpp"
 #include "introRL/iteration/subplotters.hpp"
 #include "introRL/iteration/types.hpp"
 #include "introRL/stats.hpp"
@@ -39,6 +47,9 @@ constexpr unsigned E_RET_B{2};
 
 constexpr unsigned DEAL_SIZE{11};
 
+// The most poisson mass that may be folded into the last of DEAL_SIZE deals.
+constexpr double TAIL_TOLERANCE{5e-3};
+
 constexpr unsigned POLICY_ITERATIONS{4};
 
 constexpr ProgressWidth PROGRESS_WIDTH{50};
@@ -53,15 +64,45 @@ constexpr float HOLD_LIMIT{10};
 constexpr float RENTAL_REWARD{10};
 constexpr float DISCOUNT{.9};
 
+enum class Expectation
+{
+    joint,
+    factorised,
+    model
+};
+
+constexpr Expectation EXPECTATION{Expectation::model};
+
+// How the model evaluates each policy. Its 441 states are few enough that automatic
+// evaluation would solve every policy directly; iterative evaluation instead sweeps
+// sparse products with each policy's markov chain, which is kept until the policy
+// changes, and native evaluation sweeps a host copy of the model on a pool of threads.
+constexpr EvaluationMethod EVALUATION{EvaluationMethod::iterative};
+
+constexpr size_t MEMORY_BUDGET{size_t{1} << 30};
+
+// Cached models are keyed by a hash of what they were built from. Bump this whenever
+// RentalExpecter::transitions changes what it builds, such as how it folds or clamps
+// counts or which kernels it uses, so that stale models in the temp directory are
+// rebuilt rather than reused.
+constexpr unsigned MODEL_REVISION{1};
+
+constexpr auto MODEL_PARAMETERS{
+    std::to_array<double>({
+        MODEL_REVISION, LOT_SIZE, MAX_MOVES, E_REQ_A, E_REQ_B, E_RET_A, E_RET_B, DEAL_SIZE,
+        MOVE_COST, FREE_MOVES_A_TO_B, FREE_MOVES_B_TO_A, HOLD_COST, HOLD_LIMIT,
+        RENTAL_REWARD, DISCOUNT})};
+
 template <size_t N>
 af::array totalPoisson(
     std::array<af::array, N> counts,
-    std::array<unsigned, N> expected)
+    std::array<unsigned, N> expected,
+    unsigned size)
 {
     af::array result{af::constant(1, 1, f32)};
     for (auto&& [c, e] : std::views::zip(counts, expected))
     {
-        result *= poisson(e, c);
+        result *= PoissonTable::fromSize(e, size)(c);
     }
 
     return result;
@@ -109,17 +150,10 @@ class RentalExpecter
             Index{INDEX}>;
 
 public:
-    RentalExpecter() :
-        m_nCarsA{Cars<0>::elements()},
-        m_nCarsB{Cars<1>::elements()},
-        m_nRequestsA{Deals<0>::elements()},
-        m_nRequestsB{Deals<1>::elements()},
-        m_nReturnsA{Deals<2>::elements()},
-        m_nReturnsB{Deals<3>::elements()},
-        m_pDeal{
-            totalPoisson(
-                std::to_array({m_nRequestsA, m_nRequestsB, m_nReturnsA, m_nReturnsB}),
-                std::to_array({EXPECTED_DEALS...}))}
+    RentalExpecter(size_t memoryBudget) :
+        m_memoryBudget{memoryBudget},
+        m_locationA{locationKernel(EXPECTATIONS[0], EXPECTATIONS[2])},
+        m_locationB{locationKernel(EXPECTATIONS[1], EXPECTATIONS[3])}
     {}
 
     af::array expectedReturn(
@@ -127,48 +161,306 @@ public:
         const StateValue& stateValue)
     {
         const auto actions{indicesToActions(actionIndices)};
-        const auto validActions{multiClamp(actions, -m_nCarsB, m_nCarsA)};
+        const bool actionPerState{actions.dims(0) > 1};
+
+        const auto nStates{Cars<0>::size()};
+        const auto nDeals{Deals<0>::size()};
+        const auto nActions{actions.dims(2)};
+
+        // Roughly how many state, deal and action sized temporaries are alive at once.
+        constexpr dim_t temporaries{8};
+
+        const auto cells{
+            std::max<dim_t>(m_memoryBudget / (temporaries * sizeof(float)), 1)};
+        const auto stateChunk{std::clamp<dim_t>(cells / nActions, 1, nStates)};
+        const auto dealChunk{
+            std::clamp<dim_t>(cells / (stateChunk * nActions), 1, nDeals)};
+
+        af::array result{af::constant(0, af::dim4{nStates, 1, nActions}, f32)};
+
+        for (dim_t firstState{0}; firstState < nStates; firstState += stateChunk)
+        {
+            const auto nChunkStates{std::min(stateChunk, nStates - firstState)};
+            const af::seq states{
+                static_cast<double>(firstState),
+                static_cast<double>(firstState + nChunkStates - 1)};
+
+            const auto carsA{Cars<0>::slice(firstState, nChunkStates)};
+            const auto carsB{Cars<1>::slice(firstState, nChunkStates)};
+            const af::array chunkActions{
+                actionPerState ? af::array{actions(states, af::span, af::span)} : actions};
+
+            af::array expected{af::constant(0, af::dim4{nChunkStates, 1, nActions}, f32)};
+            Outcomes outcome{};
+
+            for (dim_t firstDeal{0}; firstDeal < nDeals; firstDeal += dealChunk)
+            {
+                const auto deals{
+                    dealSlice(firstDeal, std::min(dealChunk, nDeals - firstDeal))};
+
+                outcome = outcomes(chunkActions, carsA, carsB, deals);
+
+                expected += af::sum(
+                    deals.probability * (
+                        RENTAL_REWARD * outcome.rentals +
+                        DISCOUNT * at(stateValue.unwrap<StateValue>(), outcome.nextStates)),
+                    1);
+                expected.eval();
+            }
+
+            result(states, af::span, af::span) =
+                af::select(
+                    invalidActions(chunkActions, carsA, carsB),
+                    -af::Inf,
+                    expected) -
+                moveCost(outcome.validActions) -
+                holdCost(outcome.postActionCarsA, outcome.postActionCarsB);
+        }
+
+        return result;
+    }
+
+    af::array factorisedReturn(
+        const ActionIndices& actionIndices,
+        const StateValue& stateValue)
+    {
+        constexpr auto lotSize{LOT_SIZE.unwrap<LotSize>()};
+
+        const auto actions{indicesToActions(actionIndices)};
+        const auto postAction{postActionCars(actions)};
+
+        // The value expected after the night's deals, for every pair of post action cars.
+        const auto nextValue{
+            af::matmul(
+                af::matmul(
+                    m_locationA.transitions,
+                    af::moddims(stateValue.unwrap<StateValue>().as(f32), lotSize, lotSize)),
+                m_locationB.transitions,
+                AF_MAT_NONE,
+                AF_MAT_TRANS)};
+
+        return
+            (
+                af::select(
+                    invalidActions(actions, Cars<0>::elements(), Cars<1>::elements()),
+                    -af::Inf,
+                    RENTAL_REWARD * (
+                        at(m_locationA.rentals, postAction.carsA) * m_locationB.mass +
+                        at(m_locationB.rentals, postAction.carsB) * m_locationA.mass) +
+                    DISCOUNT * at(
+                        af::flat(nextValue),
+                        postAction.carsB * lotSize + postAction.carsA)) -
+                moveCost(postAction.validActions) -
+                holdCost(postAction.carsA, postAction.carsB)
+            ).as(stateValue.unwrap<StateValue>().type());
+    }
+
+    Transitions transitions(unsigned actionIndex)
+    {
+        constexpr auto lotSize{LOT_SIZE.unwrap<LotSize>()};
+        constexpr auto nStates{lotSize * lotSize};
+
+        const auto actions{indicesToActions(ActionIndices{af::constant(actionIndex, 1, u32)})};
+        const auto postAction{postActionCars(actions)};
+        const auto invalid{
+            invalidActions(actions, Cars<0>::elements(), Cars<1>::elements())};
+
+        // Each location moves independently, so a transition's probability is the
+        // product of its locations' kernels, laid out as states x cars at A x cars at B.
+        const auto probability{
+            af::moddims(
+                m_locationA.transitions(af::flat(postAction.carsA), af::span),
+                nStates,
+                lotSize) *
+            af::moddims(
+                m_locationB.transitions(af::flat(postAction.carsB), af::span),
+                nStates,
+                1,
+                lotSize)};
+
+        const af::dim4 shape{nStates, lotSize, lotSize};
+
+        const auto kept{
+            af::where(
+                af::flat(af::tile(!invalid, 1, lotSize, lotSize) && probability > 0))};
+
+        return Transitions{
+            .from{af::flat(af::range(shape, 0, u32))(kept)},
+            .to{af::flat(af::range(shape, 2, u32) * lotSize + af::range(shape, 1, u32))(kept)},
+            .probability{af::flat(probability)(kept)},
+            .reward{
+                af::select(
+                    invalid,
+                    -af::Inf,
+                    RENTAL_REWARD * (
+                        at(m_locationA.rentals, postAction.carsA) * m_locationB.mass +
+                        at(m_locationB.rentals, postAction.carsB) * m_locationA.mass)) -
+                moveCost(postAction.validActions) -
+                holdCost(postAction.carsA, postAction.carsB)}};
+    }
+
+    af::array indicesToActions(const ActionIndices& actionIndices)
+    {
+        return actionIndices.unwrap<ActionIndices>().as(s32) - MAX_MOVES;
+    }
+
+private:
+    static constexpr std::array EXPECTATIONS{EXPECTED_DEALS...};
+
+    struct LocationKernel
+    {
+        af::array transitions;
+        af::array rentals;
+        float mass;
+    };
+
+    struct PostActionCars
+    {
+        af::array validActions;
+        af::array carsA;
+        af::array carsB;
+    };
 
+    struct DealSlice
+    {
+        af::array requestsA;
+        af::array requestsB;
+        af::array returnsA;
+        af::array returnsB;
+        af::array probability;
+    };
+
+    struct Outcomes
+    {
+        af::array validActions;
+        af::array postActionCarsA;
+        af::array postActionCarsB;
+        af::array rentals;
+        af::array nextStates;
+    };
+
+    // How one location's cars move overnight: the probability of each post action count
+    // becoming each next count, the rentals expected from each post action count
+    // (weighted by the mass of the truncated returns), and the total mass of the
+    // truncated requests and returns.
+    LocationKernel locationKernel(unsigned expectedRequests, unsigned expectedReturns)
+    {
         constexpr auto lotSize{LOT_SIZE.unwrap<LotSize>()};
+        constexpr auto dealSize{DEAL_SIZE.unwrap<DealSize>()};
+
+        const af::dim4 shape{lotSize, dealSize, dealSize};
+
+        const auto cars{af::range(shape, 0, s32)};
+        const auto requests{af::range(shape, 1, s32)};
+        const auto returns{af::range(shape, 2, s32)};
 
-        const auto postActionCarsA{af::clamp(m_nCarsA - validActions, 0, lotSize - 1)};
-        const auto postActionCarsB{af::clamp(m_nCarsB + validActions, 0, lotSize - 1)};
+        const auto pRequests{
+            PoissonTable::fromSize(expectedRequests, dealSize)(
+                af::range(af::dim4{1, dealSize}, 1, s32))};
+        const auto pReturns{
+            PoissonTable::fromSize(expectedReturns, dealSize)(
+                af::range(af::dim4{1, 1, dealSize}, 2, s32))};
 
-        const auto validRequestsA{af::min(postActionCarsA, m_nRequestsA)};
-        const auto validRequestsB{af::min(postActionCarsB, m_nRequestsB)};
+        const auto rented{af::min(cars, requests)};
+        const auto next{af::clamp(cars - rented + returns, 0, lotSize - 1)};
+
+        af::array sortedKeys{};
+        af::array order{};
+        af::sort(sortedKeys, order, af::flat(cars + next * lotSize).as(u32));
+
+        af::array uniqueKeys{};
+        af::array summed{};
+        af::sumByKey(
+            uniqueKeys,
+            summed,
+            sortedKeys,
+            af::flat(af::tile(pRequests * pReturns, lotSize))(order));
+
+        af::array transitions{af::constant(0, lotSize, lotSize, f32)};
+        transitions(uniqueKeys) = summed;
+
+        const auto returnMass{af::sum<float>(pReturns)};
+
+        return LocationKernel{
+            .transitions{transitions},
+            .rentals{
+                af::sum(
+                    pRequests * af::min(
+                        af::range(af::dim4{lotSize}, 0, s32),
+                        af::range(af::dim4{1, dealSize}, 1, s32)),
+                    1) * returnMass},
+            .mass{af::sum<float>(pRequests) * returnMass}};
+    }
+
+    PostActionCars postActionCars(const af::array& actions)
+    {
+        const auto carsA{Cars<0>::elements()};
+        const auto carsB{Cars<1>::elements()};
+        const auto validActions{multiClamp(actions, -carsB, carsA)};
+
+        constexpr auto lotSize{LOT_SIZE.unwrap<LotSize>()};
+
+        return PostActionCars{
+            .validActions{validActions},
+            .carsA{af::clamp(carsA - validActions, 0, lotSize - 1)},
+            .carsB{af::clamp(carsB + validActions, 0, lotSize - 1)}};
+    }
+
+    DealSlice dealSlice(dim_t first, dim_t count)
+    {
+        DealSlice result{
+            .requestsA{Deals<0>::slice(first, count)},
+            .requestsB{Deals<1>::slice(first, count)},
+            .returnsA{Deals<2>::slice(first, count)},
+            .returnsB{Deals<3>::slice(first, count)}};
+
+        result.probability = totalPoisson(
+            std::to_array({
+                result.requestsA,
+                result.requestsB,
+                result.returnsA,
+                result.returnsB}),
+            std::to_array({EXPECTED_DEALS...}),
+            DEAL_SIZE.unwrap<DealSize>());
+
+        return result;
+    }
+
+    Outcomes outcomes(
+        const af::array& actions,
+        const af::array& carsA,
+        const af::array& carsB,
+        const DealSlice& deals)
+    {
+        const auto validActions{multiClamp(actions, -carsB, carsA)};
+
+        constexpr auto lotSize{LOT_SIZE.unwrap<LotSize>()};
+
+        const auto postActionCarsA{af::clamp(carsA - validActions, 0, lotSize - 1)};
+        const auto postActionCarsB{af::clamp(carsB + validActions, 0, lotSize - 1)};
+
+        const auto validRequestsA{af::min(postActionCarsA, deals.requestsA)};
+        const auto validRequestsB{af::min(postActionCarsB, deals.requestsB)};
 
         const auto postReturnedCarsA{
             af::clamp(
-                postActionCarsA - validRequestsA + m_nReturnsA,
+                postActionCarsA - validRequestsA + deals.returnsA,
                 0,
                 lotSize - 1)};
         const auto postReturnedCarsB{
             af::clamp(
-                postActionCarsB - validRequestsB + m_nReturnsB,
+                postActionCarsB - validRequestsB + deals.returnsB,
                 0,
                 lotSize - 1)};
 
-        return
-            af::select(
-                invalidActions(actions, m_nCarsA, m_nCarsB),
-                -af::Inf,
-                af::sum(
-                    m_pDeal * (
-                        RENTAL_REWARD * (validRequestsA + validRequestsB) +
-                        DISCOUNT * at(
-                            stateValue.unwrap<StateValue>(),
-                            postReturnedCarsB * lotSize + postReturnedCarsA)),
-                    1)) -
-            moveCost(validActions) -
-            holdCost(postActionCarsA, postActionCarsB);
-    }
-
-    af::array indicesToActions(const ActionIndices& actionIndices)
-    {
-        return actionIndices.unwrap<ActionIndices>().as(s32) - MAX_MOVES;
+        return Outcomes{
+            .validActions{validActions},
+            .postActionCarsA{postActionCarsA},
+            .postActionCarsB{postActionCarsB},
+            .rentals{validRequestsA + validRequestsB},
+            .nextStates{postReturnedCarsB * lotSize + postReturnedCarsA}};
     }
 
-private:
     af::array invalidActions(
         const af::array& actions,
         const af::array& posLimit,
@@ -201,14 +493,10 @@ private:
             ) * HOLD_COST;
     }
 
-    const af::array m_nCarsA;
-    const af::array m_nCarsB;
-    const af::array m_nRequestsA;
-    const af::array m_nRequestsB;
-    const af::array m_nReturnsA;
-    const af::array m_nReturnsB;
+    const size_t m_memoryBudget;
 
-    const af::array m_pDeal;
+    const LocationKernel m_locationA;
+    const LocationKernel m_locationB;
 };
 
 int main()
@@ -220,7 +508,28 @@ int main()
         DealSize{DEAL_SIZE},
         E_REQ_A, E_REQ_B, E_RET_A, E_RET_B>;
 
-    Expecter expecter{};
+    Expecter expecter{MEMORY_BUDGET};
+
+    for (const auto expectation : {E_REQ_A, E_REQ_B, E_RET_A, E_RET_B})
+    {
+        const auto needed{PoissonTable::fromTolerance(expectation, TAIL_TOLERANCE)};
+
+        if (needed.size() > DEAL_SIZE)
+        {
+            throw std::runtime_error{
+                std::format(
+                    "Need a DEAL_SIZE of {} to fold at most {} of poisson({})",
+                    needed.size(),
+                    TAIL_TOLERANCE,
+                    expectation)};
+        }
+
+        std::println(
+            "Folded {:.2e} of poisson({}) past {} deals",
+            PoissonTable::fromSize(expectation, DEAL_SIZE).tailMass(),
+            expectation,
+            DEAL_SIZE - 1);
+    }
 
     indicators::show_console_cursor(false);
 
@@ -233,7 +542,7 @@ int main()
 
     bar.set_progress(0);
 
-    auto plotter{
+    AsyncSubplotter plotter{
         PolicyValueSubplotter::make(
             PLOT_SIZE,
             POLICY_ITERATIONS,
@@ -245,14 +554,46 @@ int main()
                 return expecter.indicesToActions(ActionIndices{policy.unwrap<Policy>()});
             })};
 
-    iteration::PolicyIteration policyIteration{
-        ActionCount{N_ACTIONS},
-        StateCount{LOT_SIZE * LOT_SIZE},
-        [&](const ActionIndices& actionIndices, const StateValue& stateValue)
+    const auto tick{[&] { bar.tick(); }};
+
+    // Building the model dominates start up, so it's saved to reuse across runs.
+    const auto cachedModel{
+        [&]
         {
-            return expecter.expectedReturn(actionIndices, stateValue);
-        },
-        [&] { bar.tick(); }};
+            const auto hash{parameterHash(MODEL_PARAMETERS)};
+            const auto path{
+                std::filesystem::temp_directory_path() /
+                std::format("introRL-4.7-{:016x}.model", hash)};
+
+            if (auto loaded{TransitionModel::load(path, hash)})
+            {
+                return std::move(*loaded);
+            }
+
+            TransitionModel built{
+                ActionCount{N_ACTIONS},
+                StateCount{LOT_SIZE * LOT_SIZE},
+                DISCOUNT,
+                [&](unsigned actionIndex) { return expecter.transitions(actionIndex); }};
+
+            built.save(path, hash);
+
+            return built;
+        }};
+
+    const auto policyIteration{
+        EXPECTATION == Expectation::model
+            ? iteration::PolicyIteration{cachedModel(), tick, {.method{EVALUATION}}}
+            : iteration::PolicyIteration{
+                ActionCount{N_ACTIONS},
+                StateCount{LOT_SIZE * LOT_SIZE},
+                [&](const ActionIndices& actionIndices, const StateValue& stateValue)
+                {
+                    return EXPECTATION == Expectation::factorised
+                        ? expecter.factorisedReturn(actionIndices, stateValue)
+                        : expecter.expectedReturn(actionIndices, stateValue);
+                },
+                tick}};
 
     policyIteration.iterate(plotter);
 
@@ -1,6 +1,7 @@
 #include <array>
 #include <random>
 #include <ranges>
+#include <string>
 #include <vector>
 
 #include <arrayfire.h>
@@ -9,6 +10,7 @@
 
 #include <introRL/afUtils.hpp>
 #include <introRL/iteration/algorithm.hpp>
+#include <introRL/iteration/asyncSubplotter.hpp>
 #include <introRL/iteration/subplotters.hpp>
 
 using namespace indicators::option;
@@ -73,13 +75,19 @@ public:
         return actionIndices.unwrap<ActionIndices>() + 1;
     }
 
-    af::array expectedReturn(
+    af::array stateReturn(
+        const StateIndices& stateIndices,
         const ActionIndices& actionIndices,
         const StateValue& stateValue)
     {
+        const af::array& states{stateIndices.unwrap<StateIndices>()};
+
         const auto actions{indicesToActions(actionIndices)};
 
-        const auto stateChange{m_cLoseWin * af::min(m_betLimit, actions).as(s32)};
+        const af::array stateDollars{m_stateDollars(states)};
+        const af::array betLimit{m_betLimit(states)};
+
+        const auto stateChange{m_cLoseWin * af::min(betLimit, actions).as(s32)};
 
         const auto nextValue{
             at(
@@ -88,12 +96,12 @@ public:
                     af::array{0.},
                     stateValue.unwrap<StateValue>(),
                     af::array{1.}),
-                (m_stateDollars.as(s32) + stateChange).as(u32))};
+                (stateDollars.as(s32) + stateChange).as(u32))};
 
         return
             af::select(
-                af::tile(actions, m_betLimit.dims()) >
-                af::tile(m_betLimit, actions.dims()),
+                af::tile(actions, betLimit.dims()) >
+                af::tile(betLimit, actions.dims()),
                 -af::Inf,
                 af::sum(m_pLoseWin * nextValue, 1));
     }
@@ -113,16 +121,17 @@ int main()
 
     indicators::show_console_cursor(false);
 
-    auto plotter{ValueIterationSubplotter::make(
-        PLOT_SIZE,
-        SETUPS.size(),
-        StateCount{N_STATES},
-        PLOT_ITERATIONS,
-        VALUE_X_TICKS,
-        [](const Policy& policy)
-        {
-            return Expecter::indicesToActions(ActionIndices{policy.unwrap<Policy>()});
-        })};
+    AsyncSubplotter plotter{
+        ValueIterationSubplotter::make(
+            PLOT_SIZE,
+            SETUPS.size(),
+            StateCount{N_STATES},
+            PLOT_ITERATIONS,
+            VALUE_X_TICKS,
+            [](const Policy& policy)
+            {
+                return Expecter::indicesToActions(ActionIndices{policy.unwrap<Policy>()});
+            })};
 
     ValueIteration valueIteration{ActionCount{MAX_N_ACTIONS}, StateCount{N_STATES}};
 
@@ -141,16 +150,25 @@ int main()
 
         Expecter expecter{setup.probHeads, StateCount{N_STATES}};
 
-        plotter.setupAxes(
-            title,
-            setup.policyXTicks,
-            setup.policyYTicks);
+        plotter.run(
+            [title, setup](ValueIterationSubplotter& subplotter)
+            {
+                subplotter.setupAxes(title, setup.policyXTicks, setup.policyYTicks);
+            });
 
+        // Sweeping in place from the goal down carries each win back through every
+        // smaller stake within one sweep.
         valueIteration.iterate(
-            [&](const ActionIndices& actions, const StateValue& stateValue)
+            [&](
+                const StateIndices& states,
+                const ActionIndices& actions,
+                const StateValue& stateValue)
             {
-                return expecter.expectedReturn(actions, stateValue);
+                return expecter.stateReturn(states, actions, stateValue);
             },
+            SweepOrder{
+                .order{af::flip(af::range(af::dim4{N_STATES}, 0, u32), 0)},
+                .blockSize{1}},
             plotter,
             [&] { bar.tick(); },
             setup.threshold,
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <concepts>
+#include <filesystem>
 #include <functional>
 #include <ranges>
+#include <span>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -110,7 +112,10 @@ namespace irl::bandit
     /// <typeparam name="TEnvironment">
     /// The type of bandit environment to create.
     /// </typeparam>
-    /// <typeparam name="TResult">The type of bandit result to create.</typeparam>
+    /// <typeparam name="TResult">
+    /// The type of bandit result to create, which is also given the parameters if it
+    /// can be constructed with them, and the results path if it can also take one.
+    /// </typeparam>
     /// <param name="parameters">- The input parameters for the bandit agent.</param>
     /// <param name="nActions">
     /// - The number of actions on each step of the bandit processes.
@@ -118,6 +123,10 @@ namespace irl::bandit
     /// <param name="runsPerParam">
     /// - The number of parallel runs to do for each input parameter.
     /// </param>
+    /// <param name="resultsPath">
+    /// - Where results that are saved to a file should be written, or nothing to leave
+    /// that up to the result.
+    /// </param>
     /// <returns>A tuple containing the agent, environment, and result.</returns>
     template <
         BanditAgentFactory TAgent,
@@ -126,7 +135,8 @@ namespace irl::bandit
     [[nodiscard]] decltype(auto) make(
         const std::vector<float>& parameters,
         ActionCount nActions,
-        RunsPerParameter runsPerParam)
+        RunsPerParameter runsPerParam,
+        const std::filesystem::path& resultsPath = {})
     {
         const ParameterCount nParam{std::ranges::size(parameters)};
         const auto nRuns{nParam * runsPerParam};
@@ -140,10 +150,42 @@ namespace irl::bandit
         const auto deshuffle{
             ((i % uRunsPerParam) * nParam.unwrap<ParameterCount>()) + keys};
 
+        auto result{
+            [&]
+            {
+                if constexpr (
+                    std::constructible_from<
+                        TResult,
+                        ParameterCount,
+                        ReductionKeys,
+                        std::span<const float>,
+                        std::filesystem::path>)
+                {
+                    return TResult{
+                        nParam,
+                        ReductionKeys{keys},
+                        std::span{parameters},
+                        resultsPath};
+                }
+                else if constexpr (
+                    std::constructible_from<
+                        TResult,
+                        ParameterCount,
+                        ReductionKeys,
+                        std::span<const float>>)
+                {
+                    return TResult{nParam, ReductionKeys{keys}, std::span{parameters}};
+                }
+                else
+                {
+                    return TResult{nParam, ReductionKeys{keys}};
+                }
+            }()};
+
         return std::make_tuple(
             TAgent{DeviceParameters{tiled(deshuffle)}, nActions},
             TEnvironment{nActions, nRuns},
-            TResult{nParam, ReductionKeys{keys}});
+            std::move(result));
     }
 
     /// <summary>
@@ -223,6 +265,10 @@ namespace irl::bandit
         /// bandit processes.
         /// </param>
         /// <param name="progressCallback">- The callback to call each step.</param>
+        /// <param name="resultsPath">
+        /// - Where results that are saved to a file should be written, or nothing to
+        /// leave that up to the result.
+        /// </param>
         /// <returns></returns>
         template <class TAgent, class TEnvironment, class TResult>
         requires
@@ -231,14 +277,16 @@ namespace irl::bandit
             BanditResultFactory<TResult> && BanditResult<TResult>
         [[nodiscard]] decltype(auto) learn(
             const std::vector<float>& parameters,
-            std::function<void(void)> progressCallback
+            std::function<void(void)> progressCallback,
+            const std::filesystem::path& resultsPath = {}
         ) const
         {
             auto&& [agent, environment, result]{
                 make<TAgent, TEnvironment, TResult>(
                     parameters,
                     m_nActions,
-                    m_runsPerParam)};
+                    m_runsPerParam,
+                    resultsPath)};
 
             return run(agent, environment, result, m_nStep, progressCallback);
         }
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "introRL/mappedFile.hpp"
+#include "introRL/types.hpp"
+
+namespace irl::bandit
+{
+    /// <summary>
+    /// The header at the start of a columnar result file. It is followed by nKeys null
+    /// padded key names of keySize bytes each, then nParameters float parameter values.
+    /// From dataOffset onwards, the file holds one column of capacity floats for each
+    /// key and parameter (keys outermost), of which only the first nSteps are recorded.
+    /// </summary>
+    struct ColumnarHeader
+    {
+        static constexpr std::array<char, 8> MAGIC{'I', 'R', 'L', 'C', 'O', 'L', 'S', '\0'};
+        static constexpr std::uint32_t VERSION{1};
+        static constexpr std::uint32_t KEY_SIZE{32};
+
+        std::array<char, 8> magic{MAGIC};
+        std::uint32_t version{VERSION};
+        std::uint32_t keySize{KEY_SIZE};
+        std::uint32_t nParameters{};
+        std::uint32_t nKeys{};
+        std::uint64_t nSteps{};
+        std::uint64_t capacity{};
+        std::uint64_t dataOffset{};
+    };
+
+    /// <summary>
+    /// A read only view over the series of every parameter recorded under one key of a
+    /// columnar result file. Views are invalidated when more steps are appended.
+    /// </summary>
+    class Columns
+    {
+    public:
+        /// <summary>
+        /// Creates a Columns.
+        /// </summary>
+        /// <param name="file">- The file the columns are mapped from.</param>
+        /// <param name="columns">- One series per parameter.</param>
+        Columns(
+            std::shared_ptr<const MappedFile> file,
+            std::vector<std::span<const float>> columns);
+
+        /// <summary>
+        /// Returns the series recorded for some parameter.
+        /// </summary>
+        /// <param name="parameter">- The index of the parameter.</param>
+        /// <returns>One value per recorded step.</returns>
+        [[nodiscard]] std::span<const float> operator[](size_t parameter) const;
+
+        /// <summary>
+        /// Returns the number of parameters with recorded series.
+        /// </summary>
+        /// <returns>The number of parameters with recorded series.</returns>
+        [[nodiscard]] size_t size() const;
+
+        [[nodiscard]] auto begin() const { return m_columns.begin(); }
+        [[nodiscard]] auto end() const { return m_columns.end(); }
+
+    private:
+        std::shared_ptr<const MappedFile> m_file;
+        std::vector<std::span<const float>> m_columns;
+    };
+
+    /// <summary>
+    /// Streams per step, per parameter metrics into a memory mapped columnar file, so
+    /// that results never have to fit in memory and can be read back without copies.
+    /// </summary>
+    class ColumnarSink
+    {
+    public:
+        /// <summary>
+        /// Creates a ColumnarSink, truncating any file already at the path. An empty path
+        /// writes to a temporary file that is deleted once neither the sink nor any of
+        /// its Columns are mapping it.
+        /// </summary>
+        /// <param name="path">- Where to write the columnar file, or nothing.</param>
+        /// <param name="nParameters">- The number of parameters being recorded.</param>
+        /// <param name="keys">- The names of the metrics recorded each step.</param>
+        /// <param name="parameters">
+        /// - The values of the parameters being recorded, or nothing if they're unknown.
+        /// </param>
+        ColumnarSink(
+            const std::filesystem::path& path,
+            ParameterCount nParameters,
+            std::span<const std::string_view> keys,
+            std::span<const float> parameters = {});
+
+        /// <summary>
+        /// Returns a fresh path in the temporary directory for a columnar file.
+        /// </summary>
+        /// <returns>A path that no other sink in this process has used.</returns>
+        [[nodiscard]] static std::filesystem::path temporaryPath();
+
+        /// <summary>
+        /// Records one step of results, growing the file if needed.
+        /// </summary>
+        /// <param name="step">- One value per parameter for each key, in key order.</param>
+        void append(std::span<const std::vector<float>> step);
+
+        /// <summary>
+        /// Returns views of the series recorded for every parameter under some key.
+        /// </summary>
+        /// <param name="key">- The index of the key.</param>
+        /// <returns>One series per parameter.</returns>
+        [[nodiscard]] Columns columns(size_t key) const;
+
+        /// <summary>
+        /// Returns the number of recorded steps.
+        /// </summary>
+        /// <returns>The number of recorded steps.</returns>
+        [[nodiscard]] StepCount steps() const;
+
+        /// <summary>
+        /// Returns the path of the columnar file.
+        /// </summary>
+        /// <returns>The path of the columnar file.</returns>
+        [[nodiscard]] const std::filesystem::path& path() const;
+
+    private:
+        /// <summary>
+        /// Grows every column to hold some number of steps, moving recorded data so
+        /// that each column stays contiguous.
+        /// </summary>
+        /// <param name="capacity">- The number of steps each column should hold.</param>
+        void reserve(std::uint64_t capacity);
+
+        /// <summary>
+        /// Returns the header of the mapped file.
+        /// </summary>
+        /// <returns>The header of the mapped file.</returns>
+        [[nodiscard]] const ColumnarHeader& header() const;
+
+        /// <summary>
+        /// Returns the start of the first column of the mapped file.
+        /// </summary>
+        /// <returns>The start of the first column of the mapped file.</returns>
+        [[nodiscard]] const float* data() const;
+
+        std::shared_ptr<MappedFile> m_file;
+    };
+}
\ No newline at end of file
@@ -1,27 +1,29 @@
 #pragma once
 
+#include <filesystem>
+#include <span>
 #include <vector>
 
 #include <arrayfire.h>
 
 #include "introRL/afUtils.hpp"
+#include "introRL/bandit/columnar.hpp"
 #include "introRL/bandit/types.hpp"
 #include "introRL/types.hpp"
 
 namespace irl::bandit
 {
     /// <summary>
-    /// Calculates the average reward and optimal probaility per parameter per timestep.
+    /// Calculates the average reward and optimal probaility per parameter per timestep,
+    /// streaming them into a columnar file rather than holding them in memory.
     /// </summary>
     class RewardsAndOptimality
     {
-        using ResultVector = std::vector<std::vector<float>>;
-
         struct Result;
 
     public:
-        using RewardsResult = ResultVector;
-        using OptimalityResult = ResultVector;
+        using RewardsResult = Columns;
+        using OptimalityResult = Columns;
 
         /// <summary>
         /// Creates a RewardsAndOptimality for a specific number of parameters, organized
@@ -35,9 +37,18 @@ namespace irl::bandit
         /// parallel runs. Two adjacent equal indices imply the parameters at those
         /// indices are the same, and results will be combined over them.
         /// </param>
+        /// <param name="parameters">
+        /// - The values of the parameters, recorded in the header of the results file.
+        /// </param>
+        /// <param name="path">
+        /// - Where to write the results file, or nothing to write a temporary file that is
+        /// deleted along with these results and any views of them.
+        /// </param>
         RewardsAndOptimality(
             ParameterCount nParameters,
-            const ReductionKeys& reductionKeys);
+            const ReductionKeys& reductionKeys,
+            std::span<const float> parameters = {},
+            const std::filesystem::path& path = {});
 
         /// <summary>
         /// Calculates the average reward and optimal action probability for a number of
@@ -61,11 +72,18 @@ namespace irl::bandit
         /// Returns the recorded series of average rewards and optimal action chance.
         /// </summary>
         /// <returns>
-        /// A pair of vectors holding average rewards and chance of optimal action on
-        /// each timestep.
+        /// A pair of views holding average rewards and chance of optimal action on
+        /// each timestep, mapped from the results file. The views are invalidated by
+        /// further updates.
         /// </returns>
         Result value();
 
+        /// <summary>
+        /// Returns the path of the results file.
+        /// </summary>
+        /// <returns>The path of the results file.</returns>
+        const std::filesystem::path& path() const;
+
     private:
         struct Result
         {
@@ -73,27 +91,8 @@ namespace irl::bandit
             OptimalityResult optimality;
         };
 
-        /// <summary>
-        /// Creates a vector of vectors appropriate for recording a number of sets of
-        /// results.
-        /// </summary>
-        /// <param name="nParameters">- The number of result vectors to create.</param>
-        /// <returns>A vector of result vectors, one per parameter.</returns>
-        ResultVector makeResultVector(unsigned nParameters);
-
-        /// <summary>
-        /// Splits up an arrayfire array, appending each element to a different result
-        /// vector.
-        /// </summary>
-        /// <param name="newResult">- The arrayfire array to split and append.</param>
-        /// <param name="resultVector">- The vector of vectors to append onto.</param>
-        void appendResultVector(
-            const af::array& newResult,
-            ResultVector& resultVector);
-
         ReductionKeys m_keys;
-        RewardsResult m_rewards;
-        OptimalityResult m_optimality;
+        ColumnarSink m_sink;
     };
 
     /// <summary>
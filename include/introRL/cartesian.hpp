@@ -80,6 +80,25 @@ namespace irl
         return cartesianArrays(std::views::iota(TExtent{0}, extents) ...);
     }
 
+    namespace detail
+    {
+        /// <summary>
+        /// Raises some base to some power at compile time.
+        /// </summary>
+        /// <param name="base">- The base.</param>
+        /// <param name="exponent">- The power to raise the base to.</param>
+        /// <returns>The base raised to the power.</returns>
+        constexpr dim_t power(unsigned base, unsigned exponent)
+        {
+            dim_t result{1};
+            for (unsigned i{0}; i < exponent; ++i)
+            {
+                result *= base;
+            }
+            return result;
+        }
+    }
+
     /// <summary>
     /// A type that produces arrayfire arrays which correspond to different elements of
     /// some square cartesian index.
@@ -111,32 +130,52 @@ namespace irl
         /// </returns>
         static [[nodiscard]] af::array elements()
         {
-            return af::moddims(
-                af::range(inputShape(), INDEX.unwrap<Index>(), s32), outputShape());
+            return slice(0, SIZE);
         }
 
-    private:
         /// <summary>
-        /// Returns the shape of the overall cartesian index space.
+        /// Returns the number of elements in the flattened cartesian index space.
         /// </summary>
-        /// <returns>The shape of the cartesian index space.</returns>
-        static [[nodiscard]] af::dim4 inputShape()
+        /// <returns>The number of elements in the cartesian index space.</returns>
+        static [[nodiscard]] dim_t size()
         {
-            af::dim4 result{1};
-            std::fill_n(result.dims, RANK.unwrap<Rank>(), EXTENT.unwrap<Extent>());
-            return result;
+            return SIZE;
         }
 
         /// <summary>
-        /// Returns the flattened shape of the cartesian index space.
+        /// Returns a contiguous run of the array returned by elements, computed from the
+        /// linear index of each element so the whole array is never built.
         /// </summary>
-        /// <returns>The shape of the flattened cartesian index space.</returns>
-        static [[nodiscard]] af::dim4 outputShape()
+        /// <param name="first">- The linear index of the first element to return.</param>
+        /// <param name="count">- The number of elements to return.</param>
+        /// <returns>
+        /// An arrayfire array holding count elements along the output axis.
+        /// </returns>
+        static [[nodiscard]] af::array slice(dim_t first, dim_t count)
         {
-            af::dim4 result{1};
-            result.dims[AXIS.unwrap<IndexAxis>()] =
-                std::pow(EXTENT.unwrap<Extent>(), RANK.unwrap<Rank>());
-            return result;
+            af::dim4 shape{1};
+            shape.dims[AXIS.unwrap<IndexAxis>()] = count;
+
+            return of(
+                af::range(shape, AXIS.unwrap<IndexAxis>(), s32) + static_cast<int>(first));
         }
+
+        /// <summary>
+        /// Returns this index of the cartesian elements at some linear indices. Being a
+        /// division and modulo by constants, it fuses into whatever expression consumes
+        /// it, so callers that already hold linear indices never build index arrays.
+        /// </summary>
+        /// <param name="linear">- The linear indices of some cartesian elements.</param>
+        /// <returns>This index of each of those elements, in the shape of linear.</returns>
+        static [[nodiscard]] af::array of(const af::array& linear)
+        {
+            return linear / STRIDE % static_cast<int>(EXTENT.unwrap<Extent>());
+        }
+
+    private:
+        static constexpr int STRIDE{
+            static_cast<int>(detail::power(EXTENT.unwrap<Extent>(), INDEX.unwrap<Index>()))};
+        static constexpr dim_t SIZE{
+            detail::power(EXTENT.unwrap<Extent>(), RANK.unwrap<Rank>())};
     };
 }
\ No newline at end of file
@@ -1,11 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
 
 #include <arrayfire.h>
 
 #include "introRL/types.hpp"
+#include "introRL/iteration/model.hpp"
+#include "introRL/iteration/native.hpp"
+#include "introRL/iteration/report.hpp"
 #include "introRL/iteration/types.hpp"
 #include "introRL/math/af.hpp"
 
@@ -16,8 +25,17 @@ namespace irl::iteration
         using ExpectedReturnFn =
             std::function<af::array(const ActionIndices&, const StateValue&)>;
 
+        using StateReturnFn =
+            std::function<
+                af::array(const StateIndices&, const ActionIndices&, const StateValue&)>;
+
         using ActionReductionFn = std::function<StateValue(const af::array&)>;
 
+        using EstimateFn = std::function<StateValue(const StateValue&, double)>;
+
+        using SuccessorFn =
+            std::function<StateIndices(const StateIndices&, const ActionIndices&)>;
+
         template <class ... TArgs>
         using ProgressFn = std::function<void(TArgs ...)>;
 
@@ -33,7 +51,45 @@ namespace irl::iteration
     }
 
     /// <summary>
-    /// Iteratively estimates a state value until convergence into an optimal value.
+    /// Returns the type that state values start being estimated in at some precision.
+    /// </summary>
+    /// <param name="precision">- The precision to estimate in.</param>
+    /// <returns>The type of the initial state value estimate.</returns>
+    [[nodiscard]] af::dtype valueType(Precision precision);
+
+    /// <summary>
+    /// Runs some estimator of state values at some precision. Mixed precision runs it in
+    /// single precision to a looser threshold first, then again in double precision
+    /// starting from wherever the single precision run stopped.
+    /// </summary>
+    /// <param name="precision">- The precision to estimate in.</param>
+    /// <param name="initialValue">- The initial state value of the estimate.</param>
+    /// <param name="threshold">- The threshold the final estimate should reach.</param>
+    /// <param name="estimateFn">
+    /// - Estimates a state value from some initial value to some threshold.
+    /// </param>
+    /// <returns>The estimated state value.</returns>
+    [[nodiscard]] StateValue estimateAt(
+        Precision precision,
+        const StateValue& initialValue,
+        double threshold,
+        const detail::EstimateFn& estimateFn);
+
+    /// <summary>
+    /// One resolution of a problem solved by evaluateMultigrid. States are laid out in
+    /// column major order over a grid of at most two dimensions.
+    /// </summary>
+    struct GridLevel
+    {
+        af::dim4 shape{};
+        ActionIndices actionIndices;
+        detail::ExpectedReturnFn expectedReturnFn{};
+    };
+
+    /// <summary>
+    /// Iteratively estimates a state value until convergence into an optimal value. State
+    /// values may hold a batch of variants along dimension 1, each of which stops
+    /// changing once its own estimates converge.
     /// </summary>
     /// <param name="actionIndices">
     /// - The future actions the state value will be estimated through.
@@ -53,6 +109,18 @@ namespace irl::iteration
     /// below this threshold.
     /// </param>
     /// <param name="nMaxIterations">- The maximum number of iterations.</param>
+    /// <param name="checkInterval">
+    /// - How many iterations to run between convergence checks. Checks copy the change
+    /// between estimates to the host, so checking less often lets iterations queue up on
+    /// the device, at the cost of overshooting convergence by up to checkInterval - 1
+    /// iterations.
+    /// </param>
+    /// <param name="acceleration">
+    /// - How to extrapolate each estimate from the backups so far.
+    /// </param>
+    /// <param name="reportFn">
+    /// - Receives a report of every iteration, which checks convergence every iteration.
+    /// </param>
     /// <returns>The optimal state value given some expectations.</returns>
     [[nodiscard]] StateValue evaluate(
         const ActionIndices& actionIndices,
@@ -62,8 +130,250 @@ namespace irl::iteration
         const detail::ProgressFn<const StateValue&>& progressFn =
             [](const StateValue&) {},
         double threshold = 1e-9,
+        size_t nMaxIterations = 1e3,
+        unsigned checkInterval = 1,
+        const Acceleration& acceleration = {},
+        const ReportFn& reportFn = {});
+
+    /// <summary>
+    /// Iteratively estimates an optimal state value by backing up the best action in each
+    /// state, while dropping actions that provably can't be optimal from later backups.
+    /// Later sweeps pass expectedReturnFn one row of surviving actions per state, so it
+    /// must accept actions per state. Each variant along dimension 1 of the state value
+    /// stops changing once its own estimates converge.
+    /// </summary>
+    /// <param name="actionIndices">
+    /// - The future actions the state value will be estimated through.
+    /// </param>
+    /// <param name="initialValue">- The initial state value of the iteration.</param>
+    /// <param name="expectedReturnFn">
+    /// - The expected return of some actions given a state value estimate.
+    /// </param>
+    /// <param name="actionElimination">- How to bound which actions can be optimal.</param>
+    /// <param name="progressFn">
+    /// - A callback that receives iterations of the state value.
+    /// </param>
+    /// <param name="threshold">
+    /// - Iteration stops when the change between subsequent state value estimates drops
+    /// below this threshold.
+    /// </param>
+    /// <param name="nMaxIterations">- The maximum number of iterations.</param>
+    /// <param name="reportFn">- Receives a report of every iteration.</param>
+    /// <returns>The optimal state value given some expectations.</returns>
+    [[nodiscard]] StateValue evaluateEliminating(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::ExpectedReturnFn& expectedReturnFn,
+        const ActionElimination& actionElimination,
+        const detail::ProgressFn<const StateValue&>& progressFn =
+            [](const StateValue&) {},
+        double threshold = 1e-9,
+        size_t nMaxIterations = 1e3,
+        const ReportFn& reportFn = {});
+
+    /// <summary>
+    /// Estimates a state value by solving coarse versions of a problem first, linearly
+    /// interpolating each solution onto the next finer grid as its initial value. Values
+    /// only spread one state per backup, so a warm start from a coarse grid saves most of
+    /// the sweeps the finest grid would otherwise need.
+    /// </summary>
+    /// <param name="levels">- The resolutions to solve, from coarsest to finest.</param>
+    /// <param name="initialValue">
+    /// - The initial state value of the coarsest level.
+    /// </param>
+    /// <param name="actionReductionFn">
+    /// - How to reduce the state values of future actions into one current estimate.
+    /// </param>
+    /// <param name="progressFn">
+    /// - A callback that receives iterations of the state value at every level.
+    /// </param>
+    /// <param name="threshold">
+    /// - Iteration at each level stops when the change between subsequent state value
+    /// estimates drops below this threshold.
+    /// </param>
+    /// <param name="nMaxIterations">- The maximum number of iterations per level.</param>
+    /// <returns>The optimal state value on the finest grid.</returns>
+    [[nodiscard]] StateValue evaluateMultigrid(
+        std::span<const GridLevel> levels,
+        const StateValue& initialValue,
+        const detail::ActionReductionFn& actionReductionFn,
+        const detail::ProgressFn<const StateValue&>& progressFn =
+            [](const StateValue&) {},
+        double threshold = 1e-9,
         size_t nMaxIterations = 1e3);
 
+    /// <summary>
+    /// Iteratively estimates a state value until convergence into an optimal value,
+    /// backing up blocks of states in place so that later blocks in a sweep already see
+    /// the values earlier blocks produced (Gauss-Seidel rather than Jacobi backups).
+    /// State values may hold a batch of variants along dimension 1, each of which stops
+    /// changing once its own estimates converge.
+    /// </summary>
+    /// <param name="actionIndices">
+    /// - The future actions the state value will be estimated through, either shared by
+    /// every state or one row per state.
+    /// </param>
+    /// <param name="initialValue">- The initial state value of the iteration.</param>
+    /// <param name="stateReturnFn">
+    /// - The expected return of some actions from some states given a state value
+    /// estimate.
+    /// </param>
+    /// <param name="actionReductionFn">
+    /// - How to reduce the state values of future actions into one current estimate.
+    /// </param>
+    /// <param name="sweepOrder">
+    /// - The order in which states are backed up during each sweep.
+    /// </param>
+    /// <param name="progressFn">
+    /// - A callback that receives iterations of the state value.
+    /// </param>
+    /// <param name="threshold">
+    /// - Iteration stops when the change between subsequent state value estimates drops
+    /// below this threshold.
+    /// </param>
+    /// <param name="nMaxIterations">- The maximum number of sweeps.</param>
+    /// <param name="reportFn">- Receives a report of every sweep.</param>
+    /// <returns>The optimal state value given some expectations.</returns>
+    [[nodiscard]] StateValue evaluateInPlace(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::StateReturnFn& stateReturnFn,
+        const detail::ActionReductionFn& actionReductionFn,
+        const SweepOrder& sweepOrder,
+        const detail::ProgressFn<const StateValue&>& progressFn =
+            [](const StateValue&) {},
+        double threshold = 1e-9,
+        size_t nMaxIterations = 1e3,
+        const ReportFn& reportFn = {});
+
+    /// <summary>
+    /// Estimates a state value by repeatedly backing up only the states whose values are
+    /// most likely to change, as bounded by their Bellman residuals and by the changes
+    /// made to their successors, until no state could change by more than a threshold.
+    /// Priorities are kept per state, so state values must hold a single variant.
+    /// </summary>
+    /// <param name="actionIndices">
+    /// - The future actions the state value will be estimated through, either shared by
+    /// every state or one row per state.
+    /// </param>
+    /// <param name="initialValue">- The initial state value of the iteration.</param>
+    /// <param name="stateReturnFn">
+    /// - The expected return of some actions from some states given a state value
+    /// estimate.
+    /// </param>
+    /// <param name="actionReductionFn">
+    /// - How to reduce the state values of future actions into one current estimate.
+    /// </param>
+    /// <param name="prioritySweep">
+    /// - Which states depend on which, and how many states to back up at once.
+    /// </param>
+    /// <param name="progressFn">
+    /// - A callback that receives the state value before each batch of backups.
+    /// </param>
+    /// <param name="threshold">
+    /// - Iteration stops when no state value could change by more than this threshold.
+    /// </param>
+    /// <param name="nMaxBatches">- The maximum number of batches of backups.</param>
+    /// <returns>The optimal state value given some expectations.</returns>
+    [[nodiscard]] StateValue evaluatePrioritised(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::StateReturnFn& stateReturnFn,
+        const detail::ActionReductionFn& actionReductionFn,
+        const PrioritySweep& prioritySweep,
+        const detail::ProgressFn<const StateValue&>& progressFn =
+            [](const StateValue&) {},
+        double threshold = 1e-9,
+        size_t nMaxBatches = 1e6);
+
+    /// <summary>
+    /// Where real time dynamic programming starts its trials and how it follows them.
+    /// Each trial draws batchSize start states uniformly from startStates, which may
+    /// repeat states to weight them, then follows the greedy action from each for up to
+    /// horizon steps. successorFn samples one successor of each state given one action
+    /// per state, returning an index of at least the number of states for trajectories
+    /// that end. The search ends after quietTrials trials in a row change no value by
+    /// more than the threshold. Every state starts out worth initialValue, which should
+    /// be at least its optimal value for trials to settle on optimal actions; its default
+    /// of 0 is only that optimistic when no rewards are positive.
+    /// </summary>
+    struct RealTimeSearch
+    {
+        StateIndices startStates;
+        detail::SuccessorFn successorFn{};
+        unsigned batchSize{32};
+        unsigned horizon{100};
+        unsigned quietTrials{10};
+        double initialValue{0.};
+    };
+
+    /// <summary>
+    /// Estimates an optimal state value by real time dynamic programming, which only
+    /// backs up the states visited by trajectories that follow the greedy action from
+    /// some start states, leaving states those trajectories never reach untouched.
+    /// Trajectories follow one greedy policy, so state values must hold a single variant.
+    /// </summary>
+    /// <param name="actionIndices">
+    /// - The future actions the state value will be estimated through, shared by every
+    /// state.
+    /// </param>
+    /// <param name="initialValue">- The initial state value of the iteration.</param>
+    /// <param name="stateReturnFn">
+    /// - The expected return of some actions from some states given a state value
+    /// estimate.
+    /// </param>
+    /// <param name="realTimeSearch">
+    /// - Where trials start, and how to sample their trajectories.
+    /// </param>
+    /// <param name="progressFn">
+    /// - A callback that receives the state value before each trial.
+    /// </param>
+    /// <param name="threshold">
+    /// - Iteration stops after a run of trials that change no state value by more than
+    /// this threshold.
+    /// </param>
+    /// <param name="nMaxTrials">- The maximum number of trials.</param>
+    /// <returns>The optimal value of every state reachable from the start states.</returns>
+    [[nodiscard]] StateValue evaluateRealTime(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::StateReturnFn& stateReturnFn,
+        const RealTimeSearch& realTimeSearch,
+        const detail::ProgressFn<const StateValue&>& progressFn =
+            [](const StateValue&) {},
+        double threshold = 1e-9,
+        size_t nMaxTrials = 1e4);
+
+    /// <summary>
+    /// How value iteration sweeps natively: the engine holding a host copy of the
+    /// transition model, and whether its threads relax their own partitions of states
+    /// asynchronously rather than sweeping every state in lockstep.
+    /// </summary>
+    struct NativeSweep
+    {
+        std::shared_ptr<native::NativeEngine> engine;
+        bool asynchronous{false};
+    };
+
+    /// <summary>
+    /// Estimates an optimal state value natively on the host, without going through
+    /// ArrayFire. A native engine holds one model, so state values must hold a single
+    /// variant.
+    /// </summary>
+    /// <param name="initialValue">- The initial state value of the iteration.</param>
+    /// <param name="nativeSweep">- The engine to sweep with, and how.</param>
+    /// <param name="threshold">
+    /// - Iteration stops when the change between subsequent state value estimates drops
+    /// below this threshold.
+    /// </param>
+    /// <param name="nMaxSweeps">- The maximum number of sweeps.</param>
+    /// <returns>The optimal state value, in the type of the initial value.</returns>
+    [[nodiscard]] StateValue evaluateNatively(
+        const StateValue& initialValue,
+        const NativeSweep& nativeSweep,
+        double threshold = 1e-9,
+        size_t nMaxSweeps = 1e3);
+
     /// <summary>
     /// Implements policy iteration, which swaps between policy evaluation and
     /// improvement, each slowly improving the other until an optimal policy and state
@@ -84,48 +394,187 @@ namespace irl::iteration
         /// <param name="progressFn">
         /// - An update callback called during each iteration.
         /// </param>
+        /// <param name="policyEvaluation">
+        /// - How many evaluation sweeps to run before each improvement.
+        /// </param>
+        PolicyIteration(
+            ActionCount nActions,
+            StateCount nStates,
+            const detail::ExpectedReturnFn& expectedReturnFn,
+            const detail::ProgressFn<>& progressFn = [] {},
+            const PolicyEvaluation& policyEvaluation = {});
+
+        /// <summary>
+        /// Creates a PolicyIteration that solves a batch of variants of some problem at
+        /// once, with states along dimension 0 and variants along dimension 1 of every
+        /// state value and policy.
+        /// </summary>
+        /// <param name="nActions">- The number of possible actions.</param>
+        /// <param name="nStates">- The number of possible states.</param>
+        /// <param name="nVariants">- The number of variants in the batch.</param>
+        /// <param name="expectedReturnFn">
+        /// - The expected return of some actions given a state value estimate.
+        /// </param>
+        /// <param name="progressFn">
+        /// - An update callback called during each iteration.
+        /// </param>
+        /// <param name="policyEvaluation">
+        /// - How many evaluation sweeps to run before each improvement.
+        /// </param>
         PolicyIteration(
             ActionCount nActions,
             StateCount nStates,
+            VariantCount nVariants,
             const detail::ExpectedReturnFn& expectedReturnFn,
-            const detail::ProgressFn<>& progressFn = [] {});
+            const detail::ProgressFn<>& progressFn = [] {},
+            const PolicyEvaluation& policyEvaluation = {});
+
+        /// <summary>
+        /// Creates a PolicyIteration over a precomputed transition model, which lets it
+        /// evaluate policies by solving them directly or natively on the host. Evaluations
+        /// back up in the requested precision, but improvements compare actions in the
+        /// precision of the model's matrices, which is single precision for saved models,
+        /// or in double precision when evaluating natively. A model describes one problem,
+        /// so this solves a single variant.
+        /// </summary>
+        /// <param name="model">- The model of the decision process.</param>
+        /// <param name="progressFn">
+        /// - An update callback called during each iteration.
+        /// </param>
+        /// <param name="policyEvaluation">- How to evaluate each policy.</param>
+        /// <param name="policyImprovement">- How to pick each new policy.</param>
+        PolicyIteration(
+            const TransitionModel& model,
+            const detail::ProgressFn<>& progressFn = [] {},
+            const PolicyEvaluation& policyEvaluation = {},
+            const PolicyImprovement& policyImprovement = {});
 
         /// <summary>
         /// One run of policy iteration.
         /// </summary>
         /// <param name="plotter">- The plotter in which to plot the results.</param>
-        void iterate(detail::IterationSubplotter auto&& plotter) const
+        /// <param name="reportFn">
+        /// - Receives a report of every evaluation sweep and policy improvement.
+        /// </param>
+        void iterate(
+            detail::IterationSubplotter auto&& plotter,
+            const ReportFn& reportFn = {}) const
         {
             StateValue stateValue{m_initialState};
+            StateValue improvedAt{};
             Policy policy{m_initialPolicy};
 
-            bool policyUnstable{true};
+            // The markov chain of the current policy, kept until the policy changes.
+            std::optional<PolicyModel> chain{};
+
+            // Which variants have a stable policy with a converged value, and so are
+            // held fixed through later evaluations.
+            af::array finished{
+                af::constant(0, af::dim4{1, m_initialState.unwrap<StateValue>().dims(1)}, b8)};
+
+            const bool modified{m_policyEvaluation.sweeps > 0};
+            double sweeps{static_cast<double>(m_policyEvaluation.sweeps)};
+
+            bool unfinished{true};
             for (const unsigned i : std::views::iota(unsigned{0})
-                | std::views::take_while([&](unsigned) { return policyUnstable; }))
+                | std::views::take_while([&](unsigned) { return unfinished; }))
             {
                 m_progressFn();
 
-                stateValue = evaluate(
-                    ActionIndices{policy.unwrap<Policy>()},
-                    stateValue,
-                    m_expectedReturnFn,
-                    [](af::array expectedReturnPerAction)
-                    {
-                        return StateValue{expectedReturnPerAction};
-                    });
+                const StateValue lastValue{stateValue};
+
+                const auto converged{
+                    evaluatePolicy(
+                        policy,
+                        chain,
+                        stateValue,
+                        finished,
+                        modified
+                            ? static_cast<size_t>(std::ceil(sweeps))
+                            : FULL_EVALUATION,
+                        reportFn)};
 
                 plotter.plot(policy);
                 plotter.plot(stateValue);
 
-                auto newPolicy{improve(stateValue)};
+                const auto improving{std::chrono::steady_clock::now()};
 
-                policyUnstable = af::anyTrue<bool>(policy != newPolicy);
+                auto newPolicy{improve(policy, stateValue, improvedAt)};
+
+                if (reportFn)
+                {
+                    reportFn(
+                        improvementReport(i, policy, newPolicy, lastValue, stateValue, improving));
+                }
+
+                if (af::anyTrue<bool>(policy != newPolicy))
+                {
+                    chain.reset();
+                }
+
+                // A truncated evaluation may settle on a stable policy before its value
+                // has converged, so a variant only finishes once its policy is stable and
+                // its value converges within its sweeps.
+                finished = finished || (converged && af::allTrue(policy == newPolicy, 0));
+                unfinished = !af::allTrue<bool>(finished);
 
                 policy = newPolicy;
+                sweeps = std::min(
+                    sweeps * m_policyEvaluation.growth,
+                    static_cast<double>(FULL_EVALUATION));
             }
         }
 
     private:
+        /// <summary>
+        /// Finds the value of some policy, either exactly or with a bounded number of
+        /// sweeps.
+        /// </summary>
+        /// <param name="policy">- The policy to evaluate.</param>
+        /// <param name="chain">
+        /// - The markov chain the policy induces on the model, which iterative
+        /// evaluations build if it's missing, so that each sweep is one sparse
+        /// matrix-vector product.
+        /// </param>
+        /// <param name="stateValue">
+        /// - The previous estimate, which is replaced by the policy's value.
+        /// </param>
+        /// <param name="finished">
+        /// - A row of which variants have finished, whose values are held fixed.
+        /// </param>
+        /// <param name="limit">- The maximum number of sweeps.</param>
+        /// <param name="reportFn">
+        /// - Receives a report of every sweep, or of the direct solve.
+        /// </param>
+        /// <returns>
+        /// A row of which variants converged, or were held fixed, within the sweeps.
+        /// </returns>
+        af::array evaluatePolicy(
+            const Policy& policy,
+            std::optional<PolicyModel>& chain,
+            StateValue& stateValue,
+            const af::array& finished,
+            size_t limit,
+            const ReportFn& reportFn) const;
+
+        /// <summary>
+        /// Reports on a policy improvement once the device has finished it.
+        /// </summary>
+        /// <param name="iteration">- The index of the policy iteration.</param>
+        /// <param name="policy">- The policy before improvement.</param>
+        /// <param name="newPolicy">- The policy after improvement.</param>
+        /// <param name="lastValue">- The value of the previous policy.</param>
+        /// <param name="stateValue">- The value of the policy before improvement.</param>
+        /// <param name="start">- When the improvement started.</param>
+        /// <returns>A report on the improvement.</returns>
+        static IterationReport improvementReport(
+            size_t iteration,
+            const Policy& policy,
+            const Policy& newPolicy,
+            const StateValue& lastValue,
+            const StateValue& stateValue,
+            std::chrono::steady_clock::time_point start);
+
         /// <summary>
         /// Returns the best policy given some state value estimate.
         /// </summary>
@@ -135,12 +584,37 @@ namespace irl::iteration
         /// <returns>The best policy given some state value estimate.</returns>
         Policy improve(const StateValue& stateValue) const;
 
+        /// <summary>
+        /// Returns the best policy given some state value estimate, only picking new
+        /// actions where incremental improvement finds that they might have changed.
+        /// </summary>
+        /// <param name="policy">- The current policy.</param>
+        /// <param name="stateValue">
+        /// - The state value to use as the basis for picking a policy.
+        /// </param>
+        /// <param name="improvedAt">
+        /// - The value each state had when it last triggered a pick, which is updated, or
+        /// nothing before the first improvement.
+        /// </param>
+        /// <returns>The best policy given some state value estimate.</returns>
+        Policy improve(
+            const Policy& policy,
+            const StateValue& stateValue,
+            StateValue& improvedAt) const;
+
+        static constexpr size_t FULL_EVALUATION{1'000};
+
         const ActionIndices m_allActions;
         const StateValue m_initialState;
         const Policy m_initialPolicy;
 
         const detail::ExpectedReturnFn m_expectedReturnFn;
         const detail::ProgressFn<> m_progressFn;
+        const PolicyEvaluation m_policyEvaluation;
+        const PolicyImprovement m_policyImprovement{};
+        const std::optional<TransitionModel> m_model;
+        const std::optional<TransitionGraph> m_transitionGraph;
+        const std::shared_ptr<native::NativeEngine> m_nativeEngine;
     };
 
     /// <summary>
@@ -157,9 +631,20 @@ namespace irl::iteration
         /// </summary>
         /// <param name="nActions">- The number of possible actions.</param>
         /// <param name="nStates">- The number of possible states.</param>
+        /// <param name="nVariants">
+        /// - The number of variants of the problem to solve at once, along dimension 1 of
+        /// every state value and policy.
+        /// </param>
+        /// <param name="precision">- The precision to estimate state values in.</param>
+        /// <param name="actionElimination">
+        /// - How to drop actions that can't be optimal from sweeps over every state.
+        /// </param>
         ValueIteration(
             ActionCount nActions,
-            StateCount nStates);
+            StateCount nStates,
+            VariantCount nVariants = VariantCount{1},
+            Precision precision = Precision::full,
+            const ActionElimination& actionElimination = {});
 
         /// <summary>
         /// One run of value iteration.
@@ -179,41 +664,316 @@ namespace irl::iteration
         /// - The number of digits to round state values to before picking a policy from
         /// them.
         /// </param>
-        /// <param name="nMaxIterations">- The maximum number of iterations.</param>
+        /// <param name="limit">- The maximum number of iterations.</param>
+        /// <param name="reportFn">- Receives a report of every iteration.</param>
         void iterate(
             const detail::ExpectedReturnFn& expectedReturnFn,
             detail::IterationSubplotter auto&& plotter,
             const detail::ProgressFn<>& progressFn = [] {},
             double threshold = 1e-9,
             unsigned rounding = 5,
-            unsigned limit = 100) const
+            unsigned limit = 100,
+            const ReportFn& reportFn = {}) const
         {
             const auto stateValue{
-                evaluate(
-                    m_allActions,
+                estimateAt(
+                    m_precision,
                     m_initialState,
-                    expectedReturnFn,
-                    [](af::array expectedReturnPerAction)
+                    threshold,
+                    [&](const StateValue& initialValue, double stageThreshold)
                     {
-                        return StateValue{af::max(expectedReturnPerAction, 2)};
-                    },
-                    [&](const StateValue& stateValue)
+                        const auto progress{
+                            [&](const StateValue& stateValue)
+                            {
+                                plotter.plot(stateValue);
+                                progressFn();
+                            }};
+
+                        if (m_actionElimination.discount < 1)
+                        {
+                            return evaluateEliminating(
+                                m_allActions,
+                                initialValue,
+                                expectedReturnFn,
+                                m_actionElimination,
+                                progress,
+                                stageThreshold,
+                                limit,
+                                reportFn);
+                        }
+
+                        return evaluate(
+                            m_allActions,
+                            initialValue,
+                            expectedReturnFn,
+                            maxAction,
+                            progress,
+                            stageThreshold,
+                            limit,
+                            1,
+                            {},
+                            reportFn);
+                    })};
+
+            plotGreedy(expectedReturnFn(m_allActions, stateValue), rounding, plotter);
+        }
+
+        /// <summary>
+        /// One run of value iteration, backing up states in place in some order.
+        /// </summary>
+        /// <param name="stateReturnFn">
+        /// - The expected return of some actions from some states given a state value
+        /// estimate.
+        /// </param>
+        /// <param name="sweepOrder">
+        /// - The order in which states are backed up during each sweep.
+        /// </param>
+        /// <param name="plotter">- The plotter in which to plot the results.</param>
+        /// <param name="progressFn">
+        /// - An update callback called during each iteration.
+        /// </param>
+        /// <param name="threshold">
+        /// - Iteration stops when the change between subsequent state value estimates drops
+        /// below this threshold.
+        /// </param>
+        /// <param name="rounding">
+        /// - The number of digits to round state values to before picking a policy from
+        /// them.
+        /// </param>
+        /// <param name="limit">- The maximum number of sweeps.</param>
+        /// <param name="reportFn">- Receives a report of every sweep.</param>
+        void iterate(
+            const detail::StateReturnFn& stateReturnFn,
+            const SweepOrder& sweepOrder,
+            detail::IterationSubplotter auto&& plotter,
+            const detail::ProgressFn<>& progressFn = [] {},
+            double threshold = 1e-9,
+            unsigned rounding = 5,
+            unsigned limit = 100,
+            const ReportFn& reportFn = {}) const
+        {
+            const auto stateValue{
+                estimateAt(
+                    m_precision,
+                    m_initialState,
+                    threshold,
+                    [&](const StateValue& initialValue, double stageThreshold)
                     {
-                        plotter.plot(stateValue);
-                        progressFn();
-                    },
-                    threshold)};
+                        return evaluateInPlace(
+                            m_allActions,
+                            initialValue,
+                            stateReturnFn,
+                            maxAction,
+                            sweepOrder,
+                            [&](const StateValue& stateValue)
+                            {
+                                plotter.plot(stateValue);
+                                progressFn();
+                            },
+                            stageThreshold,
+                            limit,
+                            reportFn);
+                    })};
 
-            plotter.plot(
-                Policy{
-                    math::argMax<2>(
-                        math::round(
-                            expectedReturnFn(m_allActions, stateValue),
-                            rounding))});
+            plotGreedy(
+                stateReturnFn(m_allStates, m_allActions, stateValue),
+                rounding,
+                plotter);
+        }
+
+        /// <summary>
+        /// One run of value iteration, backing up only the states whose values are most
+        /// likely to change. Only supports a single variant.
+        /// </summary>
+        /// <param name="stateReturnFn">
+        /// - The expected return of some actions from some states given a state value
+        /// estimate.
+        /// </param>
+        /// <param name="prioritySweep">
+        /// - Which states depend on which, and how many states to back up at once.
+        /// </param>
+        /// <param name="plotter">- The plotter in which to plot the results.</param>
+        /// <param name="progressFn">
+        /// - An update callback called before each batch of backups.
+        /// </param>
+        /// <param name="threshold">
+        /// - Iteration stops when no state value could change by more than this
+        /// threshold.
+        /// </param>
+        /// <param name="rounding">
+        /// - The number of digits to round state values to before picking a policy from
+        /// them.
+        /// </param>
+        /// <param name="limit">- The maximum number of batches of backups.</param>
+        void iterate(
+            const detail::StateReturnFn& stateReturnFn,
+            const PrioritySweep& prioritySweep,
+            detail::IterationSubplotter auto&& plotter,
+            const detail::ProgressFn<>& progressFn = [] {},
+            double threshold = 1e-9,
+            unsigned rounding = 5,
+            unsigned limit = 100'000) const
+        {
+            const auto stateValue{
+                estimateAt(
+                    m_precision,
+                    m_initialState,
+                    threshold,
+                    [&](const StateValue& initialValue, double stageThreshold)
+                    {
+                        return evaluatePrioritised(
+                            m_allActions,
+                            initialValue,
+                            stateReturnFn,
+                            maxAction,
+                            prioritySweep,
+                            [&](const StateValue& stateValue)
+                            {
+                                plotter.plot(stateValue);
+                                progressFn();
+                            },
+                            stageThreshold,
+                            limit);
+                    })};
+
+            plotGreedy(
+                stateReturnFn(m_allStates, m_allActions, stateValue),
+                rounding,
+                plotter);
+        }
+
+        /// <summary>
+        /// One run of value iteration by real time dynamic programming, backing up only
+        /// the states reachable from some start states under the greedy policy. Only
+        /// supports a single variant.
+        /// </summary>
+        /// <param name="stateReturnFn">
+        /// - The expected return of some actions from some states given a state value
+        /// estimate.
+        /// </param>
+        /// <param name="realTimeSearch">
+        /// - Where trials start, and how to sample their trajectories.
+        /// </param>
+        /// <param name="plotter">- The plotter in which to plot the results.</param>
+        /// <param name="progressFn">- An update callback called before each trial.</param>
+        /// <param name="threshold">
+        /// - Iteration stops after a run of trials that change no state value by more
+        /// than this threshold.
+        /// </param>
+        /// <param name="rounding">
+        /// - The number of digits to round state values to before picking a policy from
+        /// them.
+        /// </param>
+        /// <param name="limit">- The maximum number of trials.</param>
+        void iterate(
+            const detail::StateReturnFn& stateReturnFn,
+            const RealTimeSearch& realTimeSearch,
+            detail::IterationSubplotter auto&& plotter,
+            const detail::ProgressFn<>& progressFn = [] {},
+            double threshold = 1e-9,
+            unsigned rounding = 5,
+            unsigned limit = 10'000) const
+        {
+            // Trials only settle on optimal actions from optimistic values, which the
+            // default initial value of 0 is not when any reward is positive.
+            const auto stateValue{
+                estimateAt(
+                    m_precision,
+                    StateValue{m_initialState.unwrap<StateValue>() + realTimeSearch.initialValue},
+                    threshold,
+                    [&](const StateValue& initialValue, double stageThreshold)
+                    {
+                        return evaluateRealTime(
+                            m_allActions,
+                            initialValue,
+                            stateReturnFn,
+                            realTimeSearch,
+                            [&](const StateValue& stateValue)
+                            {
+                                plotter.plot(stateValue);
+                                progressFn();
+                            },
+                            stageThreshold,
+                            limit);
+                    })};
+
+            plotGreedy(
+                stateReturnFn(m_allStates, m_allActions, stateValue),
+                rounding,
+                plotter);
+        }
+
+        /// <summary>
+        /// One run of value iteration, sweeping natively on the host over the model held
+        /// by a native engine. Native sweeps don't report their progress, so the state
+        /// value is only plotted once it has converged. Only supports a single variant.
+        /// </summary>
+        /// <param name="nativeSweep">- The engine to sweep with, and how.</param>
+        /// <param name="plotter">- The plotter in which to plot the results.</param>
+        /// <param name="progressFn">- An update callback called before sweeping.</param>
+        /// <param name="threshold">
+        /// - Iteration stops when the change between subsequent state value estimates drops
+        /// below this threshold.
+        /// </param>
+        /// <param name="limit">- The maximum number of sweeps.</param>
+        void iterate(
+            const NativeSweep& nativeSweep,
+            detail::IterationSubplotter auto&& plotter,
+            const detail::ProgressFn<>& progressFn = [] {},
+            double threshold = 1e-9,
+            unsigned limit = 1'000) const
+        {
+            progressFn();
+
+            const auto stateValue{
+                evaluateNatively(m_initialState, nativeSweep, threshold, limit)};
+
+            plotter.plot(stateValue);
+            plotter.plot(nativeGreedy(nativeSweep, stateValue));
         }
 
     private:
+        /// <summary>
+        /// Reduces expected returns to the return of the best action in each state.
+        /// </summary>
+        /// <param name="expectedReturnPerAction">
+        /// - The expected return of each action in each state.
+        /// </param>
+        /// <returns>The expected return of the best action in each state.</returns>
+        static StateValue maxAction(const af::array& expectedReturnPerAction);
+
+        /// <summary>
+        /// Plots the policy that greedily picks the best action in each state.
+        /// </summary>
+        /// <param name="expectedReturnPerAction">
+        /// - The expected return of each action in each state.
+        /// </param>
+        /// <param name="rounding">
+        /// - The number of digits to round expected returns to before picking actions.
+        /// </param>
+        /// <param name="plotter">- The plotter in which to plot the policy.</param>
+        static void plotGreedy(
+            const af::array& expectedReturnPerAction,
+            unsigned rounding,
+            detail::IterationSubplotter auto&& plotter)
+        {
+            plotter.plot(
+                Policy{math::argMax<2>(math::round(expectedReturnPerAction, rounding))});
+        }
+
+        /// <summary>
+        /// Returns the policy that greedily picks the best action in each state of the
+        /// model held by a native engine.
+        /// </summary>
+        /// <param name="nativeSweep">- The engine holding the model.</param>
+        /// <param name="stateValue">- The state value to pick actions from.</param>
+        /// <returns>The lowest index among the best actions in each state.</returns>
+        static Policy nativeGreedy(const NativeSweep& nativeSweep, const StateValue& stateValue);
+
         const ActionIndices m_allActions;
+        const StateIndices m_allStates;
         const StateValue m_initialState;
+        const Precision m_precision;
+        const ActionElimination m_actionElimination;
     };
 }
\ No newline at end of file
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <arrayfire.h>
+
+#include "introRL/iteration/types.hpp"
+
+namespace irl::iteration
+{
+    /// <summary>
+    /// Wraps a subplotter so that plotting happens on a background thread. The solver
+    /// only enqueues device copies of its estimates, while the background thread copies
+    /// them to the host and draws them in order, so plotting only stalls convergence
+    /// when the queue is full. Every queued estimate holds its own device copy, so the
+    /// queue's capacity bounds how much device memory plotting can take.
+    /// </summary>
+    /// <typeparam name="TSubplotter">The subplotter to plot with.</typeparam>
+    template <class TSubplotter>
+    class AsyncSubplotter
+    {
+    public:
+        using Task = std::function<void(TSubplotter&)>;
+        using WantedFn = std::function<bool(unsigned)>;
+
+        /// <summary>
+        /// Creates an AsyncSubplotter and starts its background thread.
+        /// </summary>
+        /// <param name="subplotter">- The subplotter to plot with.</param>
+        /// <param name="wantedFn">
+        /// - Whether to plot the state value estimate with some index since the last
+        /// policy. Unwanted estimates are never copied, and are passed on to the
+        /// subplotter's skip() if it has one. Defaults to the subplotter's wants() if it
+        /// has one, and to every estimate otherwise.
+        /// </param>
+        /// <param name="capacity">
+        /// - The most tasks to queue at once, beyond which enqueueing waits for the
+        /// background thread to catch up.
+        /// </param>
+        explicit AsyncSubplotter(
+            TSubplotter subplotter,
+            WantedFn wantedFn = {},
+            size_t capacity = 16
+        ) :
+            m_subplotter{std::move(subplotter)},
+            m_wantedFn{wantedFn ? std::move(wantedFn) : subplotterWantedFn()},
+            m_capacity{std::max<size_t>(capacity, 1)},
+            m_worker{[this] { work(); }}
+        {}
+
+        AsyncSubplotter(const AsyncSubplotter&) = delete;
+        AsyncSubplotter& operator=(const AsyncSubplotter&) = delete;
+
+        ~AsyncSubplotter()
+        {
+            finish();
+        }
+
+        /// <summary>
+        /// Enqueues a policy to be plotted.
+        /// </summary>
+        /// <param name="policy">- The policy to plot.</param>
+        void plot(const Policy& policy)
+        {
+            m_count = 0;
+
+            run(
+                [snapshot{Policy{policy.unwrap<Policy>().copy()}}](TSubplotter& subplotter)
+                {
+                    subplotter.plot(snapshot);
+                });
+        }
+
+        /// <summary>
+        /// Enqueues a state value estimate to be plotted, if it is wanted.
+        /// </summary>
+        /// <param name="stateValue">- The state value estimate to plot.</param>
+        void plot(const StateValue& stateValue)
+        {
+            if (m_wantedFn(m_count++))
+            {
+                run(
+                    [snapshot{StateValue{stateValue.unwrap<StateValue>().copy()}}](
+                        TSubplotter& subplotter)
+                    {
+                        subplotter.plot(snapshot);
+                    });
+            }
+            else if constexpr (requires (TSubplotter subplotter) { subplotter.skip(); })
+            {
+                run([](TSubplotter& subplotter) { subplotter.skip(); });
+            }
+        }
+
+        /// <summary>
+        /// Enqueues some other work on the subplotter, such as setting up its axes, to
+        /// run in order with the plots. Waits for room if the queue is full.
+        /// </summary>
+        /// <param name="task">- The work to do on the subplotter.</param>
+        void run(Task task)
+        {
+            {
+                std::unique_lock lock{m_mutex};
+                m_drained.wait(lock, [this] { return m_tasks.size() < m_capacity; });
+                m_tasks.push_back(std::move(task));
+            }
+
+            m_ready.notify_one();
+        }
+
+        /// <summary>
+        /// Waits for every enqueued plot to be drawn, then shows the final plot.
+        /// </summary>
+        void show()
+        {
+            finish();
+
+            if (m_error)
+            {
+                std::rethrow_exception(std::exchange(m_error, nullptr));
+            }
+
+            m_subplotter.show();
+        }
+
+    private:
+        /// <summary>
+        /// Returns which state value estimates the subplotter wants, which is every one
+        /// unless it can say otherwise.
+        /// </summary>
+        /// <returns>Whether the subplotter wants the estimate with some index.</returns>
+        WantedFn subplotterWantedFn() const
+        {
+            if constexpr (requires (const TSubplotter subplotter) { subplotter.wants(0U); })
+            {
+                // Only reads what the subplotter was made with, so it is safe to call
+                // while the background thread plots.
+                return [this](unsigned iteration) { return m_subplotter.wants(iteration); };
+            }
+            else
+            {
+                return [](unsigned) { return true; };
+            }
+        }
+
+        /// <summary>
+        /// Runs enqueued tasks until finished and the queue is empty.
+        /// </summary>
+        void work()
+        {
+            for (;;)
+            {
+                Task task{};
+
+                {
+                    std::unique_lock lock{m_mutex};
+                    m_ready.wait(lock, [this] { return m_finished || !m_tasks.empty(); });
+
+                    if (m_tasks.empty())
+                    {
+                        return;
+                    }
+
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+
+                m_drained.notify_one();
+
+                if (!m_error)
+                {
+                    try
+                    {
+                        task(m_subplotter);
+                    }
+                    catch (...)
+                    {
+                        m_error = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        /// <summary>
+        /// Stops the background thread once it has drained the queue.
+        /// </summary>
+        void finish()
+        {
+            if (!m_worker.joinable())
+            {
+                return;
+            }
+
+            {
+                std::scoped_lock lock{m_mutex};
+                m_finished = true;
+            }
+
+            m_ready.notify_one();
+            m_worker.join();
+        }
+
+        TSubplotter m_subplotter;
+        const WantedFn m_wantedFn;
+        const size_t m_capacity;
+
+        unsigned m_count{};
+
+        std::mutex m_mutex{};
+        std::condition_variable m_ready{};
+        std::condition_variable m_drained{};
+        std::deque<Task> m_tasks{};
+        bool m_finished{};
+        std::exception_ptr m_error{};
+
+        std::thread m_worker;
+    };
+}
\ No newline at end of file
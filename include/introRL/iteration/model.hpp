@@ -0,0 +1,274 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <arrayfire.h>
+
+#include "introRL/types.hpp"
+#include "introRL/iteration/types.hpp"
+
+namespace irl::iteration
+{
+    /// <summary>
+    /// Every transition one action can make, as coordinate lists of equal length, along
+    /// with the expected immediate reward of taking that action in each state. Repeated
+    /// coordinates are summed, and states where the action isn't available should have a
+    /// reward of negative infinity.
+    /// </summary>
+    struct Transitions
+    {
+        af::array from;
+        af::array to;
+        af::array probability;
+        af::array reward;
+    };
+
+    /// <summary>
+    /// The markov chain some policy induces on a transition model, as a sparse (CSR)
+    /// states by states transition matrix and one expected reward per state.
+    /// </summary>
+    struct PolicyModel
+    {
+        af::array transitions;
+        af::array rewards;
+    };
+
+    /// <summary>
+    /// The header at the start of a binary model file. Every section starts at a 64 byte
+    /// aligned offset. At entryOffsetsOffset are nActions + 1 uint64 offsets of each
+    /// action's first entry. At rowOffsetsOffset are nActions rows of nStates + 1 int32
+    /// CSR row offsets, relative to the action's first entry. At columnsOffset and
+    /// probabilitiesOffset are nEntries int32 columns and float probabilities. At
+    /// rewardsOffset are nActions rows of nStates float rewards.
+    /// </summary>
+    struct ModelHeader
+    {
+        static constexpr std::array<char, 8> MAGIC{'I', 'R', 'L', 'M', 'O', 'D', 'E', 'L'};
+        static constexpr std::uint32_t VERSION{1};
+
+        std::array<char, 8> magic{MAGIC};
+        std::uint32_t version{VERSION};
+        std::uint32_t nActions{};
+        std::uint32_t nStates{};
+        std::uint32_t reserved{};
+        double discount{};
+        std::uint64_t parameterHash{};
+        std::uint64_t nEntries{};
+        std::uint64_t entryOffsetsOffset{};
+        std::uint64_t rowOffsetsOffset{};
+        std::uint64_t columnsOffset{};
+        std::uint64_t probabilitiesOffset{};
+        std::uint64_t rewardsOffset{};
+    };
+
+    /// <summary>
+    /// Hashes the parameters a model was built from, so that a saved model can tell when
+    /// it's stale.
+    /// </summary>
+    /// <param name="parameters">- The parameters the model was built from.</param>
+    /// <returns>The 64 bit FNV-1a hash of the parameters' bytes.</returns>
+    [[nodiscard]] std::uint64_t parameterHash(std::span<const double> parameters);
+
+    /// <summary>
+    /// A precomputed model of some finite markov decision process, which keeps one sparse
+    /// (CSR) transition matrix and one reward vector per action so that each bellman
+    /// backup is a sparse matrix-vector product.
+    /// </summary>
+    class TransitionModel
+    {
+    public:
+        using TransitionsFn = std::function<Transitions(unsigned)>;
+
+        /// <summary>
+        /// Creates a TransitionModel, building one action at a time so that only one
+        /// action's unmerged transitions are held at once.
+        /// </summary>
+        /// <param name="nActions">- The number of possible actions.</param>
+        /// <param name="nStates">- The number of possible states.</param>
+        /// <param name="discount">- How much to discount future rewards.</param>
+        /// <param name="transitionsFn">
+        /// - Returns every transition some action index can make.
+        /// </param>
+        TransitionModel(
+            ActionCount nActions,
+            StateCount nStates,
+            double discount,
+            const TransitionsFn& transitionsFn);
+
+        /// <summary>
+        /// Loads a model saved with save, reading the arrays straight out of the mapped
+        /// file into device memory.
+        /// </summary>
+        /// <param name="path">- The path of the model file.</param>
+        /// <param name="parameterHash">
+        /// - The hash of the parameters the model should have been built from.
+        /// </param>
+        /// <returns>
+        /// The saved model, or nothing if there's no file at the path, it was built from
+        /// other parameters, or it isn't a complete model file of the current format.
+        /// </returns>
+        [[nodiscard]] static std::optional<TransitionModel> load(
+            const std::filesystem::path& path,
+            std::uint64_t parameterHash);
+
+        /// <summary>
+        /// Saves the model in the binary model format, with probabilities and rewards
+        /// stored as floats.
+        /// </summary>
+        /// <param name="path">- Where to write the model file.</param>
+        /// <param name="parameterHash">
+        /// - The hash of the parameters the model was built from.
+        /// </param>
+        void save(const std::filesystem::path& path, std::uint64_t parameterHash) const;
+
+        /// <summary>
+        /// Returns the expected return of some actions given a state value estimate.
+        /// </summary>
+        /// <param name="actionIndices">
+        /// - Either actions shared by every state (along dimension 2) or one action per
+        /// state (along dimension 0).
+        /// </param>
+        /// <param name="stateValue">- The state value estimate to back up.</param>
+        /// <returns>
+        /// The expected return of every state, with one column per shared action along
+        /// dimension 2 or a single column for one action per state.
+        /// </returns>
+        [[nodiscard]] af::array expectedReturn(
+            const ActionIndices& actionIndices,
+            const StateValue& stateValue) const;
+
+        /// <summary>
+        /// Returns the transitions and rewards of following some policy.
+        /// </summary>
+        /// <param name="policy">- The action to take in each state.</param>
+        /// <returns>The markov chain the policy induces.</returns>
+        [[nodiscard]] PolicyModel underPolicy(const Policy& policy) const;
+
+        /// <summary>
+        /// Returns the expected return of some actions from only some states, touching
+        /// only the transitions out of those states.
+        /// </summary>
+        /// <param name="stateIndices">- The states to back up.</param>
+        /// <param name="actionIndices">
+        /// - The actions to back up, either shared by every state or one per state.
+        /// </param>
+        /// <param name="stateValue">- The current estimate of the state value.</param>
+        /// <returns>
+        /// The expected return of each action from each state, with states along
+        /// dimension 0 and shared actions along dimension 2.
+        /// </returns>
+        [[nodiscard]] af::array stateReturn(
+            const StateIndices& stateIndices,
+            const ActionIndices& actionIndices,
+            const StateValue& stateValue) const;
+
+        /// <summary>
+        /// Samples one successor of each of some states on the device, as real time
+        /// dynamic programming needs to follow trajectories through the model.
+        /// </summary>
+        /// <param name="stateIndices">- The states to sample successors of.</param>
+        /// <param name="actionIndices">- The action taken in each state.</param>
+        /// <returns>
+        /// One successor per state, or the number of states wherever the action's
+        /// probabilities run out before the uniform draw does, ending the trajectory.
+        /// </returns>
+        [[nodiscard]] StateIndices sample(
+            const StateIndices& stateIndices,
+            const ActionIndices& actionIndices) const;
+
+        /// <summary>
+        /// Returns the exact value of following some policy by solving its bellman
+        /// equation as a dense linear system, so is only suitable for modest models.
+        /// </summary>
+        /// <param name="policy">- The action to take in each state.</param>
+        /// <returns>The value of every state under the policy.</returns>
+        [[nodiscard]] StateValue solve(const Policy& policy) const;
+
+        /// <summary>
+        /// Returns which states each state's backup depends on, weighted by the largest
+        /// discounted probability of any action moving between them.
+        /// </summary>
+        /// <returns>A transition graph of the model.</returns>
+        [[nodiscard]] TransitionGraph transitionGraph() const;
+
+        /// <summary>
+        /// Returns the transition matrix of some action.
+        /// </summary>
+        /// <param name="action">- The index of the action.</param>
+        /// <returns>
+        /// The sparse (CSR) states by states transition matrix of the action, or an empty
+        /// array if it never transitions.
+        /// </returns>
+        [[nodiscard]] const af::array& matrix(unsigned action) const;
+
+        /// <summary>
+        /// Returns the expected immediate reward of every action in every state.
+        /// </summary>
+        /// <returns>The rewards, with states along dimension 0 and actions along 2.</returns>
+        [[nodiscard]] const af::array& rewards() const;
+
+        /// <summary>
+        /// Returns the number of possible actions.
+        /// </summary>
+        /// <returns>The number of possible actions.</returns>
+        [[nodiscard]] ActionCount actions() const;
+
+        /// <summary>
+        /// Returns the number of possible states.
+        /// </summary>
+        /// <returns>The number of possible states.</returns>
+        [[nodiscard]] StateCount states() const;
+
+        /// <summary>
+        /// Returns the discount applied to future rewards.
+        /// </summary>
+        /// <returns>The discount applied to future rewards.</returns>
+        [[nodiscard]] double discount() const;
+
+    private:
+        /// <summary>
+        /// Creates an empty TransitionModel to be filled in by load.
+        /// </summary>
+        /// <param name="nActions">- The number of possible actions.</param>
+        /// <param name="nStates">- The number of possible states.</param>
+        /// <param name="discount">- How much to discount future rewards.</param>
+        TransitionModel(unsigned nActions, unsigned nStates, double discount);
+
+        /// <summary>
+        /// Keeps the entries of one action's transition matrix alongside every other
+        /// action's, so that policies and graphs can be built from all of them at once.
+        /// </summary>
+        /// <param name="action">- The action the entries belong to.</param>
+        /// <param name="keys">- The sorted linear coordinates of each entry.</param>
+        /// <param name="probabilities">- The probability of each entry.</param>
+        void appendEntries(
+            unsigned action,
+            const af::array& keys,
+            const af::array& probabilities);
+
+        /// <summary>
+        /// Returns the expected return of one action in every state.
+        /// </summary>
+        /// <param name="action">- The index of the action.</param>
+        /// <param name="value">- The state value estimate to back up.</param>
+        /// <returns>One expected return per state, in the type of the state value.</returns>
+        [[nodiscard]] af::array backup(unsigned action, const af::array& value) const;
+
+        unsigned m_nActions;
+        unsigned m_nStates;
+        double m_discount;
+
+        std::vector<af::array> m_matrices{};
+        af::array m_rewards{};
+
+        af::array m_keys{};
+        af::array m_probabilities{};
+        af::array m_actions{};
+    };
+}
\ No newline at end of file
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "introRL/iteration/model.hpp"
+
+namespace irl::iteration::native
+{
+    /// <summary>
+    /// A fixed pool of threads that run the tasks of a parallel loop together with the
+    /// thread that started it.
+    /// </summary>
+    class WorkerPool
+    {
+    public:
+        /// <summary>
+        /// Creates a WorkerPool.
+        /// </summary>
+        /// <param name="nThreads">
+        /// - The number of threads to run tasks on, including the calling thread.
+        /// </param>
+        explicit WorkerPool(unsigned nThreads = std::thread::hardware_concurrency());
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        ~WorkerPool();
+
+        /// <summary>
+        /// Runs some number of tasks across the pool, returning once they've all finished.
+        /// Tasks are handed out in order as threads become free.
+        /// </summary>
+        /// <param name="nTasks">- The number of tasks to run.</param>
+        /// <param name="task">- Runs the task with some index.</param>
+        void forEach(size_t nTasks, const std::function<void(size_t)>& task);
+
+        /// <summary>
+        /// Returns the number of threads that run tasks, including the calling thread.
+        /// </summary>
+        /// <returns>The number of threads that run tasks.</returns>
+        [[nodiscard]] unsigned threads() const;
+
+    private:
+        /// <summary>
+        /// Waits for loops to start and helps run their tasks until the pool stops.
+        /// </summary>
+        void work();
+
+        /// <summary>
+        /// Runs tasks of the current loop until none are left.
+        /// </summary>
+        void runTasks();
+
+        std::mutex m_mutex{};
+        std::condition_variable m_started{};
+        std::condition_variable m_finished{};
+
+        const std::function<void(size_t)>* m_task{};
+        size_t m_nTasks{};
+        std::atomic<size_t> m_next{};
+        unsigned m_busy{};
+        std::uint64_t m_generation{};
+        bool m_stopping{};
+        std::exception_ptr m_error{};
+
+        std::vector<std::thread> m_threads{};
+    };
+
+    /// <summary>
+    /// A host copy of a transition model, as one CSR matrix with a row for every state
+    /// and action (actions innermost), so that every backup of one state reads one
+    /// contiguous run of transitions.
+    /// </summary>
+    class NativeModel
+    {
+    public:
+        /// <summary>
+        /// Copies a transition model to the host.
+        /// </summary>
+        /// <param name="model">- The model to copy.</param>
+        explicit NativeModel(const TransitionModel& model);
+
+        /// <summary>
+        /// Returns the expected return of taking some action in some state.
+        /// </summary>
+        /// <param name="state">- The index of the state.</param>
+        /// <param name="action">- The index of the action.</param>
+        /// <param name="value">- The state value estimate to back up.</param>
+        /// <returns>The expected return of the action.</returns>
+        [[nodiscard]] double backup(
+            unsigned state,
+            unsigned action,
+            std::span<const double> value) const;
+
+        /// <summary>
+        /// Returns the expected return of taking some action in some state, given a state
+        /// value estimate that other threads may be writing to, which is read atomically.
+        /// </summary>
+        /// <param name="state">- The index of the state.</param>
+        /// <param name="action">- The index of the action.</param>
+        /// <param name="value">- The shared state value estimate to back up.</param>
+        /// <returns>The expected return of the action.</returns>
+        [[nodiscard]] double backupShared(
+            unsigned state,
+            unsigned action,
+            std::span<double> value) const;
+
+        /// <summary>
+        /// Returns the number of possible actions.
+        /// </summary>
+        /// <returns>The number of possible actions.</returns>
+        [[nodiscard]] unsigned actions() const;
+
+        /// <summary>
+        /// Returns the number of possible states.
+        /// </summary>
+        /// <returns>The number of possible states.</returns>
+        [[nodiscard]] unsigned states() const;
+
+    private:
+        unsigned m_nActions;
+        unsigned m_nStates;
+        double m_discount;
+
+        std::vector<std::uint32_t> m_rowOffsets{};
+        std::vector<std::uint32_t> m_columns{};
+        std::vector<float> m_probabilities{};
+        std::vector<double> m_rewards{};
+    };
+
+    /// <summary>
+    /// Evaluates and improves policies of a native model without going through
+    /// ArrayFire, sweeping tiles of consecutive states across a pool of threads.
+    /// </summary>
+    class NativeEngine
+    {
+    public:
+        /// <summary>
+        /// Creates a NativeEngine.
+        /// </summary>
+        /// <param name="model">- The model to solve.</param>
+        /// <param name="nThreads">- The number of threads to sweep with.</param>
+        /// <param name="tileSize">
+        /// - The number of consecutive states each thread backs up at a time.
+        /// </param>
+        explicit NativeEngine(
+            NativeModel model,
+            unsigned nThreads = std::thread::hardware_concurrency(),
+            unsigned tileSize = 256);
+
+        /// <summary>
+        /// Iteratively estimates the value of following some policy until convergence.
+        /// </summary>
+        /// <param name="policy">- The action to take in each state.</param>
+        /// <param name="initialValue">- The initial state value of the iteration.</param>
+        /// <param name="threshold">
+        /// - Iteration stops when the change between subsequent state value estimates
+        /// drops below this threshold.
+        /// </param>
+        /// <param name="nMaxSweeps">- The maximum number of sweeps.</param>
+        /// <returns>The value of following the policy.</returns>
+        [[nodiscard]] std::vector<double> evaluate(
+            std::span<const unsigned> policy,
+            std::vector<double> initialValue,
+            double threshold = 1e-9,
+            size_t nMaxSweeps = 1e3);
+
+        /// <summary>
+        /// Iteratively estimates the optimal state value until convergence.
+        /// </summary>
+        /// <param name="initialValue">- The initial state value of the iteration.</param>
+        /// <param name="threshold">
+        /// - Iteration stops when the change between subsequent state value estimates
+        /// drops below this threshold.
+        /// </param>
+        /// <param name="nMaxSweeps">- The maximum number of sweeps.</param>
+        /// <returns>The optimal state value.</returns>
+        [[nodiscard]] std::vector<double> evaluateOptimal(
+            std::vector<double> initialValue,
+            double threshold = 1e-9,
+            size_t nMaxSweeps = 1e3);
+
+        /// <summary>
+        /// Estimates the optimal state value by chaotic relaxation, where each thread
+        /// keeps backing up its own partition of states in place against the shared
+        /// estimate without waiting for the others, while a monitor thread watches every
+        /// partition's latest change. Once every partition's change drops below the
+        /// threshold, synchronous sweeps confirm convergence.
+        /// </summary>
+        /// <param name="initialValue">- The initial state value of the iteration.</param>
+        /// <param name="threshold">
+        /// - Iteration stops when the change between subsequent state value estimates
+        /// drops below this threshold.
+        /// </param>
+        /// <param name="nMaxSweeps">
+        /// - The maximum number of passes over each partition, which the synchronous
+        /// sweeps share.
+        /// </param>
+        /// <returns>The optimal state value.</returns>
+        [[nodiscard]] std::vector<double> evaluateOptimalAsynchronously(
+            std::vector<double> initialValue,
+            double threshold = 1e-9,
+            size_t nMaxSweeps = 1e3);
+
+        /// <summary>
+        /// Returns the best policy given some state value estimate, picking the lowest
+        /// action index among ties.
+        /// </summary>
+        /// <param name="value">
+        /// - The state value to use as the basis for picking a policy.
+        /// </param>
+        /// <returns>The best action in each state.</returns>
+        [[nodiscard]] std::vector<unsigned> improve(std::span<const double> value);
+
+        /// <summary>
+        /// Returns the largest change made by the last synchronous sweep, which is at
+        /// most the threshold of the last estimate if it converged.
+        /// </summary>
+        /// <returns>The largest change made by the last synchronous sweep.</returns>
+        [[nodiscard]] double lastChange() const;
+
+    private:
+        using BackupFn = std::function<double(unsigned, std::span<const double>)>;
+
+        /// <summary>
+        /// Sweeps backups over every state until the largest change drops below a
+        /// threshold.
+        /// </summary>
+        /// <param name="backupFn">- Backs up one state given the last estimate.</param>
+        /// <param name="value">- The initial state value of the iteration.</param>
+        /// <param name="threshold">- The threshold the largest change should reach.</param>
+        /// <param name="nMaxSweeps">- The maximum number of sweeps.</param>
+        /// <returns>The converged state value.</returns>
+        [[nodiscard]] std::vector<double> sweep(
+            const BackupFn& backupFn,
+            std::vector<double> value,
+            double threshold,
+            size_t nMaxSweeps);
+
+        /// <summary>
+        /// Returns the number of tiles the states are split into.
+        /// </summary>
+        /// <returns>The number of tiles.</returns>
+        [[nodiscard]] size_t tiles() const;
+
+        /// <summary>
+        /// Runs some function over every tile of states across the pool.
+        /// </summary>
+        /// <param name="tileFn">
+        /// - Runs on the index, first state and one past the last state of a tile.
+        /// </param>
+        void forEachTile(const std::function<void(size_t, unsigned, unsigned)>& tileFn);
+
+        const NativeModel m_model;
+        const unsigned m_tileSize;
+
+        double m_lastChange{std::numeric_limits<double>::max()};
+
+        WorkerPool m_pool;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace irl::iteration
+{
+    /// <summary>
+    /// What one iteration of the iteration engine did. Sweeps report their bellman
+    /// residual and where their time went, while policy improvements also report how many
+    /// actions changed, along with the largest change in value since the last policy.
+    /// Reporting synchronises the device around each timed step so that time is charged
+    /// to the step that spent it, which slows iteration down slightly.
+    /// </summary>
+    struct IterationReport
+    {
+        size_t iteration{};
+        double residual{};
+        double sweepSeconds{};
+        double expectedReturnSeconds{};
+        double reductionSeconds{};
+        size_t deviceBytes{};
+        std::optional<size_t> policyChanges{};
+    };
+
+    using ReportFn = std::function<void(const IterationReport&)>;
+
+    /// <summary>
+    /// Returns how much device memory arrayfire has handed out to live arrays.
+    /// </summary>
+    /// <returns>The number of bytes in locked device buffers.</returns>
+    [[nodiscard]] size_t deviceBytesInUse();
+
+    /// <summary>
+    /// Formats a report as one line of JSON, writing values that aren't finite as null.
+    /// </summary>
+    /// <param name="report">- The report to format.</param>
+    /// <returns>A JSON object without a trailing newline.</returns>
+    [[nodiscard]] std::string toJson(const IterationReport& report);
+
+    /// <summary>
+    /// Returns a report callback that writes each report to a stream as a line of JSON.
+    /// </summary>
+    /// <param name="out">- The stream to write to, which must outlive the callback.</param>
+    /// <returns>A report callback that writes JSON lines.</returns>
+    [[nodiscard]] ReportFn jsonLines(std::ostream& out);
+}
\ No newline at end of file
@@ -145,6 +145,19 @@ namespace irl::iteration
         /// <param name="stateValue">- A state value estimate for the coin flip problem.</param>
         void plot(const iteration::StateValue& stateValue);
 
+        /// <summary>
+        /// Counts a state value iteration without plotting it, for callers that already
+        /// know it isn't in the iterations to plot.
+        /// </summary>
+        void skip();
+
+        /// <summary>
+        /// Whether a state value iteration is one of the iterations to plot.
+        /// </summary>
+        /// <param name="iteration">- The iteration since the last policy.</param>
+        /// <returns>True if the iteration would be plotted.</returns>
+        [[nodiscard]] bool wants(unsigned iteration) const;
+
         /// <summary>
         /// Plots an estimate of the optimal policy on the bottom plot, then moves the subplotter
         /// to the next column.
@@ -172,6 +185,11 @@ namespace irl::iteration
 
         explicit ValueIterationSubplotter(M m);
 
+        /// <summary>
+        /// Moves on to the next state value iteration.
+        /// </summary>
+        void advance();
+
         /// <summary>
         /// Gets the current axes for the policy plot.
         /// </summary>
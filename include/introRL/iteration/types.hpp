@@ -24,6 +24,14 @@ namespace irl::iteration
         using stronk::stronk;
     };
 
+    /// <summary>
+    /// An array of state indices.
+    /// </summary>
+    struct StateIndices : twig::stronk<StateIndices, af::array>
+    {
+        using stronk::stronk;
+    };
+
     /// <summary>
     /// An array of values, one per state, which represent the future reward available in
     /// each state.
@@ -32,4 +40,162 @@ namespace irl::iteration
     {
         using stronk::stronk;
     };
+
+    /// <summary>
+    /// How to extrapolate from the estimates of a fixed point iteration.
+    /// </summary>
+    enum class AccelerationMethod
+    {
+        /// <summary>
+        /// Takes each backed up estimate as is.
+        /// </summary>
+        none,
+
+        /// <summary>
+        /// Steps past each backed up estimate by some relaxation factor.
+        /// </summary>
+        overRelaxation,
+
+        /// <summary>
+        /// Combines the last few backed up estimates to minimise their residuals
+        /// (Anderson acceleration).
+        /// </summary>
+        anderson
+    };
+
+    /// <summary>
+    /// How to accelerate a fixed point iteration. Over relaxation moves each estimate
+    /// relaxation times as far as a plain backup would, and Anderson acceleration mixes
+    /// the last depth estimates.
+    /// </summary>
+    struct Acceleration
+    {
+        AccelerationMethod method{AccelerationMethod::none};
+        double relaxation{1.};
+        unsigned depth{5};
+    };
+
+    /// <summary>
+    /// How policy iteration finds the value of each policy.
+    /// </summary>
+    enum class EvaluationMethod
+    {
+        /// <summary>
+        /// Sweeps bellman backups over every state until the value converges.
+        /// </summary>
+        iterative,
+
+        /// <summary>
+        /// Solves the linear system of the policy's transition model exactly.
+        /// </summary>
+        direct,
+
+        /// <summary>
+        /// Solves directly when a transition model is available and has few enough
+        /// states, and iteratively otherwise.
+        /// </summary>
+        automatic,
+
+        /// <summary>
+        /// Sweeps bellman backups, and picks each new policy, over a host copy of the
+        /// transition model on a pool of threads, without going through ArrayFire.
+        /// </summary>
+        native
+    };
+
+    /// <summary>
+    /// The floating point precision that state values are estimated in.
+    /// </summary>
+    enum class Precision
+    {
+        /// <summary>
+        /// Estimates in single precision (f32), which moves half the bytes per sweep.
+        /// </summary>
+        single,
+
+        /// <summary>
+        /// Estimates in double precision (f64).
+        /// </summary>
+        full,
+
+        /// <summary>
+        /// Sweeps in single precision until the changes between sweeps are about as small
+        /// as single precision can resolve, then polishes the estimate in double
+        /// precision.
+        /// </summary>
+        mixed
+    };
+
+    /// <summary>
+    /// How thoroughly policy iteration evaluates each policy before improving it. Zero
+    /// sweeps evaluates every policy until convergence, while some positive number of
+    /// sweeps gives modified policy iteration, which multiplies that number by growth
+    /// after every improvement. Sweeps are ignored by policies that are solved directly,
+    /// which automatic evaluation does for models of at most directLimit states, while
+    /// iterative evaluation may be accelerated and run at some precision.
+    /// </summary>
+    struct PolicyEvaluation
+    {
+        unsigned sweeps{0};
+        double growth{1.};
+        EvaluationMethod method{EvaluationMethod::automatic};
+        unsigned directLimit{2'048};
+        Acceleration acceleration{};
+        Precision precision{Precision::single};
+    };
+
+    /// <summary>
+    /// How policy iteration picks each new policy. Incremental improvement, which needs a
+    /// transition model, only picks new actions in states with some successor whose value
+    /// has moved by more than tolerance since that successor last triggered a pick, and
+    /// keeps the previous policy everywhere else.
+    /// </summary>
+    struct PolicyImprovement
+    {
+        bool incremental{false};
+        double tolerance{1e-6};
+    };
+
+    /// <summary>
+    /// How value iteration drops actions that can't be optimal. With a discount below 1,
+    /// the residual of each sweep bounds how far its expected returns are from optimal,
+    /// so actions trailing the best by more than twice that bound are never backed up
+    /// again. Discounts of 1 leave every action in play.
+    /// </summary>
+    struct ActionElimination
+    {
+        double discount{1.};
+    };
+
+    /// <summary>
+    /// A sparse (CSR) states by states matrix whose entry (s, s') bounds how far the
+    /// backup of state s can move per unit change in the value of state s'. Entries of 1
+    /// are always safe for discounts of at most 1. Multiplying it by changes in value
+    /// finds how much those changes can disturb each of their predecessors.
+    /// </summary>
+    struct TransitionGraph : twig::stronk<TransitionGraph, af::array>
+    {
+        using stronk::stronk;
+    };
+
+    /// <summary>
+    /// How a prioritised sweep finds which states to back up, and how many of the most
+    /// disturbed states it backs up together. Every batch syncs with the host once, so
+    /// batches should be large enough to amortise that.
+    /// </summary>
+    struct PrioritySweep
+    {
+        TransitionGraph transitionGraph;
+        unsigned batchSize{256};
+    };
+
+    /// <summary>
+    /// The order in which an in-place sweep backs up states, and how many consecutive
+    /// states it backs up together.
+    /// </summary>
+    struct SweepOrder
+    {
+        StateIndices order;
+        unsigned blockSize{1};
+    };
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace irl
+{
+    /// <summary>
+    /// A file whose contents are mapped into memory, so that reads and writes go
+    /// through the page cache rather than through explicit file io.
+    /// </summary>
+    class MappedFile
+    {
+    public:
+        /// <summary>
+        /// How a mapped file may be used.
+        /// </summary>
+        enum class Access
+        {
+            /// <summary>
+            /// Maps an existing file which may only be read.
+            /// </summary>
+            read,
+
+            /// <summary>
+            /// Creates (or truncates) a file which may be resized and written.
+            /// </summary>
+            write
+        };
+
+        /// <summary>
+        /// Opens and maps a file.
+        /// </summary>
+        /// <param name="path">- The path of the file to map.</param>
+        /// <param name="access">- How the file will be used.</param>
+        MappedFile(const std::filesystem::path& path, Access access);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+        /// <summary>
+        /// Grows or shrinks the file, remapping it. Any spans previously taken from the
+        /// file are invalidated.
+        /// </summary>
+        /// <param name="size">- The new size of the file in bytes.</param>
+        void resize(size_t size);
+
+        /// <summary>
+        /// Writes any modified pages back to the file.
+        /// </summary>
+        void flush();
+
+        /// <summary>
+        /// Returns the path of the mapped file.
+        /// </summary>
+        /// <returns>The path of the mapped file.</returns>
+        [[nodiscard]] const std::filesystem::path& path() const;
+
+        /// <summary>
+        /// Returns the size of the mapped file.
+        /// </summary>
+        /// <returns>The size of the mapped file in bytes.</returns>
+        [[nodiscard]] size_t size() const;
+
+        /// <summary>
+        /// Returns the mapped contents of a file opened for writing.
+        /// </summary>
+        /// <returns>A span over every byte in the file.</returns>
+        [[nodiscard]] std::span<std::byte> bytes();
+
+        /// <summary>
+        /// Returns the mapped contents of the file.
+        /// </summary>
+        /// <returns>A span over every byte in the file.</returns>
+        [[nodiscard]] std::span<const std::byte> bytes() const;
+
+    private:
+        /// <summary>
+        /// Maps the current extent of the file into memory.
+        /// </summary>
+        void map();
+
+        /// <summary>
+        /// Removes the current mapping, if there is one.
+        /// </summary>
+        void unmap();
+
+        /// <summary>
+        /// Releases every resource held by the mapping.
+        /// </summary>
+        void close();
+
+        std::filesystem::path m_path{};
+        Access m_access{};
+        size_t m_size{};
+        std::byte* m_data{};
+
+#ifdef _WIN32
+        void* m_file{};
+        void* m_mapping{};
+#else
+        int m_file{-1};
+#endif
+    };
+}
\ No newline at end of file
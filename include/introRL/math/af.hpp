@@ -1,15 +1,12 @@
 #pragma once
 
-#include <functional>
-#include <ranges>
-#include <utility>
-
 #include "arrayfire.h"
 
 namespace irl::math
 {
     /// <summary>
-    /// Returns indices of the maximum elements along some dimension.
+    /// Returns indices of the maximum elements along some dimension. Ties go to the
+    /// lowest index, and slices with no comparable maximum (all NaN) give index 0.
     /// </summary>
     /// <typeparam name="DIMENSION">
     /// The dimension along which to find the index of the maximum.
@@ -21,45 +18,22 @@ namespace irl::math
     {
         static_assert(DIMENSION < 4, "af::array has only 4 dimensions.");
 
-        constexpr auto discard{
-            [] <class T, class D>(T && t, D)
-        {
-            return std::forward<decltype(t)>(t);
-        }};
-
-        constexpr auto elementGetter{
-            [] <size_t ... PRE, size_t ... POST>
-            (
-                const af::array & m,
-                unsigned i,
-                std::index_sequence<PRE ...>,
-                std::index_sequence<POST ...>)
-        {
-            return m(discard(af::span, PRE)..., i, discard(af::span, POST)...);
-        }};
-
-        auto resultShape{m.dims()};
-        resultShape.dims[DIMENSION] = 1;
-
-        auto max{af::constant(-af::Inf, resultShape, m.type())};
-        auto maxI{af::constant(0, max.dims(), u32)};
+        const auto extent{m.dims(DIMENSION)};
 
-        for (const auto i : std::views::iota(dim_t{0}, m.dims(DIMENSION)))
-        {
-            const auto element{
-                elementGetter(
-                    m,
-                    i,
-                    std::make_index_sequence<DIMENSION>(),
-                    std::make_index_sequence<3 - DIMENSION>())};
+        af::dim4 tiling{1, 1, 1, 1};
+        tiling[DIMENSION] = extent;
 
-            const auto larger{element > max};
+        // af::max's own indices don't promise an order for ties on every backend, so the
+        // lowest index of each maximum is found with a second reduction.
+        const auto candidates{
+            af::select(
+                m == af::tile(af::max(m, DIMENSION), tiling),
+                af::range(m.dims(), DIMENSION, u32),
+                static_cast<double>(extent))};
 
-            max = af::select(larger, element, max);
-            maxI = af::select(larger, i, maxI);
-        }
+        const auto lowest{af::min(candidates, DIMENSION)};
 
-        return maxI;
+        return af::select(lowest == extent, 0., lowest).as(u32);
     }
 
     /// <summary>
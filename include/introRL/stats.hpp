@@ -6,7 +6,7 @@
 #include <set>
 #include <vector>
 
-namespace af { class array; }
+#include <arrayfire.h>
 
 namespace irl
 {
@@ -32,7 +32,9 @@ namespace irl
 
     /// <summary>
     /// Returns the probability of some number of events happening during some time
-    /// period given some expected amount of events.
+    /// period given some expected amount of events. Any count is accepted, with the
+    /// probability continued through the gamma function between integers and zero at
+    /// negative integers.
     /// </summary>
     /// <param name="expectation">- The expected number of events per time.</param>
     /// <param name="samples">
@@ -44,6 +46,66 @@ namespace irl
     /// </returns>
     af::array poisson(unsigned expectation, const af::array& samples);
 
+    /// <summary>
+    /// A cached table of poisson probabilities over counts [0, size), whose last bucket
+    /// also holds the probability of every larger count, so the table sums to one.
+    /// </summary>
+    class PoissonTable
+    {
+    public:
+        /// <summary>
+        /// Returns the smallest table whose folded tail is within some tolerance.
+        /// </summary>
+        /// <param name="expectation">- The expected number of events per time.</param>
+        /// <param name="tolerance">
+        /// - The most probability that may be folded into the last bucket.
+        /// </param>
+        /// <returns>A table of poisson probabilities.</returns>
+        [[nodiscard]] static PoissonTable fromTolerance(unsigned expectation, double tolerance);
+
+        /// <summary>
+        /// Returns a table of some size, folding whatever lies beyond it into the last
+        /// bucket.
+        /// </summary>
+        /// <param name="expectation">- The expected number of events per time.</param>
+        /// <param name="size">- The number of counts in the table.</param>
+        /// <returns>A table of poisson probabilities.</returns>
+        [[nodiscard]] static PoissonTable fromSize(unsigned expectation, unsigned size);
+
+        /// <summary>
+        /// Looks up the probabilities of some counts, which must be less than the size of
+        /// the table.
+        /// </summary>
+        /// <param name="samples">- An array of arbitrary shape of counts.</param>
+        /// <returns>
+        /// An array with the same shape as samples, holding the probability of each count.
+        /// </returns>
+        [[nodiscard]] af::array operator()(const af::array& samples) const;
+
+        /// <summary>
+        /// Returns the number of counts in the table.
+        /// </summary>
+        /// <returns>The number of counts in the table.</returns>
+        [[nodiscard]] unsigned size() const;
+
+        /// <summary>
+        /// Returns the probability of counts past the table, which the last bucket holds.
+        /// </summary>
+        /// <returns>The probability folded into the last bucket.</returns>
+        [[nodiscard]] double tailMass() const;
+
+    private:
+        /// <summary>
+        /// Creates a PoissonTable.
+        /// </summary>
+        /// <param name="probabilities">- The folded probability of each count.</param>
+        /// <param name="tailMass">- The probability folded into the last bucket.</param>
+        PoissonTable(af::array probabilities, double tailMass);
+
+        af::array m_probabilities;
+        double m_tailMass;
+    };
+
     /// <summary>
     /// Randomly returns a single element of the set.
     /// </summary>
@@ -163,6 +163,14 @@ namespace irl
         using stronk_default_unit::stronk_default_unit;
     };
 
+    /// <summary>
+    /// The number of variants of some problem being solved together in one batch.
+    /// </summary>
+    struct VariantCount : twig::stronk_default_unit<VariantCount, unsigned>
+    {
+        using stronk_default_unit::stronk_default_unit;
+    };
+
     /// <summary>
     /// The ratio of RunCount / ParameterCount; that is, the number of runs to execute
     /// for each input parameter in some parallel learning process.
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <limits>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "introRL/bandit/columnar.hpp"
+#include "introRL/mappedFile.hpp"
+#include "introRL/types.hpp"
+
+namespace irl::bandit
+{
+    namespace
+    {
+        constexpr std::uint64_t INITIAL_CAPACITY{1'024};
+        constexpr std::uint64_t DATA_ALIGNMENT{64};
+
+        /// <summary>
+        /// Maps a columnar file for writing. Files at unnamed paths are made in the
+        /// temporary directory and removed when the last reference to them is released.
+        /// </summary>
+        /// <param name="path">- Where to write the columnar file, or nothing.</param>
+        /// <returns>The mapped file.</returns>
+        std::shared_ptr<MappedFile> openFile(const std::filesystem::path& path)
+        {
+            if (!path.empty())
+            {
+                return std::make_shared<MappedFile>(path, MappedFile::Access::write);
+            }
+
+            return std::shared_ptr<MappedFile>{
+                new MappedFile{ColumnarSink::temporaryPath(), MappedFile::Access::write},
+                [](MappedFile* file)
+                {
+                    const auto temporary{file->path()};
+
+                    delete file;
+
+                    std::error_code error;
+                    std::filesystem::remove(temporary, error);
+                }};
+        }
+
+        /// <summary>
+        /// Returns a mutable header of some mapped columnar file.
+        /// </summary>
+        /// <param name="file">- The mapped columnar file.</param>
+        /// <returns>The header at the start of the file.</returns>
+        ColumnarHeader& mutableHeader(MappedFile& file)
+        {
+            return *reinterpret_cast<ColumnarHeader*>(file.bytes().data());
+        }
+
+        /// <summary>
+        /// Returns the start of the first column of some mapped columnar file.
+        /// </summary>
+        /// <param name="file">- The mapped columnar file.</param>
+        /// <returns>The start of the first column of the file.</returns>
+        float* mutableData(MappedFile& file)
+        {
+            return reinterpret_cast<float*>(
+                file.bytes().data() + mutableHeader(file).dataOffset);
+        }
+    }
+
+    Columns::Columns(
+        std::shared_ptr<const MappedFile> file,
+        std::vector<std::span<const float>> columns
+    ) :
+        m_file{std::move(file)},
+        m_columns{std::move(columns)}
+    {}
+
+    std::span<const float> Columns::operator[](size_t parameter) const
+    {
+        return m_columns[parameter];
+    }
+
+    size_t Columns::size() const
+    {
+        return m_columns.size();
+    }
+
+    ColumnarSink::ColumnarSink(
+        const std::filesystem::path& path,
+        ParameterCount nParameters,
+        std::span<const std::string_view> keys,
+        std::span<const float> parameters
+    ) :
+        m_file{openFile(path)}
+    {
+        const auto nParams{nParameters.unwrap<ParameterCount>()};
+
+        if (!parameters.empty() && parameters.size() != nParams)
+        {
+            throw std::invalid_argument{"Need one value per parameter"};
+        }
+
+        const auto keysOffset{sizeof(ColumnarHeader)};
+        const auto parametersOffset{keysOffset + keys.size() * ColumnarHeader::KEY_SIZE};
+        const auto dataOffset{
+            (parametersOffset + nParams * sizeof(float) + DATA_ALIGNMENT - 1)
+            / DATA_ALIGNMENT * DATA_ALIGNMENT};
+
+        m_file->resize(dataOffset);
+
+        auto bytes{m_file->bytes()};
+
+        const ColumnarHeader initial{
+            .nParameters{nParams},
+            .nKeys{static_cast<std::uint32_t>(keys.size())},
+            .dataOffset{dataOffset}};
+
+        std::memcpy(bytes.data(), &initial, sizeof(initial));
+
+        for (auto&& [i, key] : std::views::enumerate(keys))
+        {
+            std::memcpy(
+                bytes.data() + keysOffset + i * ColumnarHeader::KEY_SIZE,
+                key.data(),
+                std::min<size_t>(key.size(), ColumnarHeader::KEY_SIZE - 1));
+        }
+
+        auto parameterValues{
+            reinterpret_cast<float*>(bytes.data() + parametersOffset)};
+
+        if (parameters.empty())
+        {
+            std::fill_n(parameterValues, nParams, std::numeric_limits<float>::quiet_NaN());
+        }
+        else
+        {
+            std::ranges::copy(parameters, parameterValues);
+        }
+
+        reserve(INITIAL_CAPACITY);
+    }
+
+    std::filesystem::path ColumnarSink::temporaryPath()
+    {
+        static const auto session{std::random_device{}()};
+        static std::atomic<unsigned> count{};
+
+        return
+            std::filesystem::temp_directory_path() /
+            std::format("introRL-{:08x}-{}.cols", session, count++);
+    }
+
+    void ColumnarSink::append(std::span<const std::vector<float>> step)
+    {
+        const auto nKeys{header().nKeys};
+        const auto nParams{header().nParameters};
+
+        if (step.size() != nKeys)
+        {
+            throw std::invalid_argument{"Need one set of values per key"};
+        }
+
+        if (header().nSteps == header().capacity)
+        {
+            reserve(header().capacity * 2);
+        }
+
+        auto& h{mutableHeader(*m_file)};
+        auto first{mutableData(*m_file)};
+
+        for (auto&& [key, values] : std::views::enumerate(step))
+        {
+            if (values.size() != nParams)
+            {
+                throw std::invalid_argument{"Need one value per parameter"};
+            }
+
+            for (auto&& [parameter, value] : std::views::enumerate(values))
+            {
+                first[(key * nParams + parameter) * h.capacity + h.nSteps] = value;
+            }
+        }
+
+        ++h.nSteps;
+    }
+
+    Columns ColumnarSink::columns(size_t key) const
+    {
+        const auto& h{header()};
+        const auto first{data()};
+
+        return Columns{
+            m_file,
+            std::views::iota(size_t{0}, size_t{h.nParameters})
+            | std::views::transform(
+                [&](size_t parameter)
+                {
+                    return std::span<const float>{
+                        first + (key * h.nParameters + parameter) * h.capacity,
+                        h.nSteps};
+                })
+            | std::ranges::to<std::vector>()};
+    }
+
+    StepCount ColumnarSink::steps() const
+    {
+        return StepCount{static_cast<unsigned>(header().nSteps)};
+    }
+
+    const std::filesystem::path& ColumnarSink::path() const
+    {
+        return m_file->path();
+    }
+
+    void ColumnarSink::reserve(std::uint64_t capacity)
+    {
+        const auto old{header()};
+        const std::uint64_t nColumns{std::uint64_t{old.nKeys} * old.nParameters};
+
+        m_file->resize(old.dataOffset + nColumns * capacity * sizeof(float));
+
+        auto first{mutableData(*m_file)};
+
+        for (const auto column : std::views::iota(std::uint64_t{1}, nColumns)
+            | std::views::reverse)
+        {
+            std::memmove(
+                first + column * capacity,
+                first + column * old.capacity,
+                old.nSteps * sizeof(float));
+        }
+
+        mutableHeader(*m_file).capacity = capacity;
+    }
+
+    const ColumnarHeader& ColumnarSink::header() const
+    {
+        return *reinterpret_cast<const ColumnarHeader*>(
+            std::as_const(*m_file).bytes().data());
+    }
+
+    const float* ColumnarSink::data() const
+    {
+        return reinterpret_cast<const float*>(
+            std::as_const(*m_file).bytes().data() + header().dataOffset);
+    }
+}
\ No newline at end of file
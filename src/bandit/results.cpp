@@ -1,22 +1,32 @@
-#include <ranges>
+#include <array>
+#include <filesystem>
+#include <span>
+#include <string_view>
 #include <vector>
 
 #include <arrayfire.h>
 
 #include "introRL/afUtils.hpp"
+#include "introRL/bandit/columnar.hpp"
 #include "introRL/bandit/types.hpp"
 #include "introRL/types.hpp"
 #include "introRL/bandit/results.hpp"
 
 namespace irl::bandit
 {
+    namespace
+    {
+        constexpr auto KEYS{std::to_array<std::string_view>({"rewards", "optimality"})};
+    }
+
     RewardsAndOptimality::RewardsAndOptimality(
         ParameterCount nParameters,
-        const ReductionKeys & reductionKeys
+        const ReductionKeys & reductionKeys,
+        std::span<const float> parameters,
+        const std::filesystem::path& path
     ) :
         m_keys{reductionKeys},
-        m_rewards{makeResultVector(nParameters.unwrap<ParameterCount>())},
-        m_optimality{makeResultVector(nParameters.unwrap<ParameterCount>())}
+        m_sink{path, nParameters, KEYS, parameters}
     {}
 
     void RewardsAndOptimality::update(
@@ -31,32 +41,21 @@ namespace irl::bandit
 
         af::sumByKey(outKeys, outScan, rKeys, rewards.unwrap<Rewards>());
         const auto nRunsPerKey{rKeys.dims(0) / outKeys.dims(0)};
-        appendResultVector(outScan / nRunsPerKey, m_rewards);
+        auto hostRewards{toVector<float>(outScan / nRunsPerKey)};
 
         af::countByKey(outKeys, outScan, rKeys, actions == optimalActions);
-        appendResultVector(outScan.as(f32) / nRunsPerKey, m_optimality);
-    }
+        auto hostOptimality{toVector<float>(outScan.as(f32) / nRunsPerKey)};
 
-    RewardsAndOptimality::Result RewardsAndOptimality::value()
-    {
-        return { m_rewards, m_optimality };
+        m_sink.append(std::to_array({std::move(hostRewards), std::move(hostOptimality)}));
     }
 
-    RewardsAndOptimality::ResultVector RewardsAndOptimality::makeResultVector(
-        unsigned nParameters)
+    RewardsAndOptimality::Result RewardsAndOptimality::value()
     {
-        return std::views::repeat(std::vector<float>{}, nParameters)
-            | std::ranges::to<std::vector>();
+        return { m_sink.columns(0), m_sink.columns(1) };
     }
 
-    void RewardsAndOptimality::appendResultVector(
-        const af::array& newResult,
-        ResultVector& resultVector)
+    const std::filesystem::path& RewardsAndOptimality::path() const
     {
-        std::vector<float> hostResult{toVector<float>(newResult)};
-        for (auto&& [r, v] : std::views::zip(hostResult, resultVector))
-        {
-            v.push_back(r);
-        }
+        return m_sink.path();
     }
 }
\ No newline at end of file
@@ -1,16 +1,481 @@
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <functional>
 #include <limits>
+#include <memory>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #include <arrayfire.h>
 
+#include "introRL/afUtils.hpp"
 #include "introRL/types.hpp"
 #include "introRL/iteration/algorithm.hpp"
+#include "introRL/iteration/model.hpp"
+#include "introRL/iteration/native.hpp"
+#include "introRL/iteration/report.hpp"
 #include "introRL/iteration/types.hpp"
 #include "introRL/math/af.hpp"
 
 namespace irl::iteration
 {
+    namespace
+    {
+        // Mixed precision switches to double precision once changes between single
+        // precision sweeps drop below this, around where they stop resolving values in
+        // the hundreds.
+        constexpr double MIXED_THRESHOLD{1e-4};
+
+        // Native evaluations always run in double precision, to the same threshold as
+        // iterative ones.
+        constexpr double NATIVE_THRESHOLD{1e-9};
+
+        // The largest k that topk supports on every backend.
+        constexpr dim_t TOPK_LIMIT{256};
+
+        /// <summary>
+        /// Returns the expected return of following a policy for one step, given the
+        /// markov chain it induces.
+        /// </summary>
+        /// <param name="chain">- The markov chain the policy induces.</param>
+        /// <param name="discount">- How much to discount future rewards.</param>
+        /// <param name="stateValue">- The state value estimate to back up.</param>
+        /// <returns>One expected return per state, in the type of the state value.</returns>
+        af::array chainReturn(
+            const PolicyModel& chain,
+            double discount,
+            const StateValue& stateValue)
+        {
+            const af::array& value{stateValue.unwrap<StateValue>()};
+
+            if (chain.transitions.isempty())
+            {
+                return chain.rewards.as(value.type());
+            }
+
+            return (
+                chain.rewards +
+                discount * af::matmul(
+                    chain.transitions,
+                    af::flat(value).as(chain.transitions.type()))
+            ).as(value.type());
+        }
+
+        /// <summary>
+        /// Returns a markov chain with its transitions and rewards in double precision.
+        /// </summary>
+        /// <param name="chain">- The markov chain to widen.</param>
+        /// <returns>The same markov chain, in double precision.</returns>
+        PolicyModel widened(const PolicyModel& chain)
+        {
+            const af::array& transitions{chain.transitions};
+
+            return PolicyModel{
+                .transitions{
+                    transitions.isempty()
+                        ? af::array{}
+                        : af::sparse(
+                            transitions.dims(0),
+                            transitions.dims(1),
+                            af::sparseGetValues(transitions).as(f64),
+                            af::sparseGetRowIdx(transitions),
+                            af::sparseGetColIdx(transitions),
+                            AF_STORAGE_CSR)},
+                .rewards{chain.rewards.as(f64)}};
+        }
+
+        /// <summary>
+        /// Returns the transpose of a sparse (CSR) matrix, also in CSR.
+        /// </summary>
+        /// <param name="matrix">- The matrix to transpose.</param>
+        /// <returns>The transposed matrix.</returns>
+        af::array transposeCSR(const af::array& matrix)
+        {
+            const af::array coordinates{af::sparseConvertTo(matrix, AF_STORAGE_COO)};
+            const af::array rows{af::sparseGetRowIdx(coordinates)};
+            const af::array columns{af::sparseGetColIdx(coordinates)};
+
+            // Sorting by column then row leaves the transpose's entries in row major order.
+            af::array sortedKeys{};
+            af::array order{};
+            af::sort(
+                sortedKeys,
+                order,
+                columns.as(u64) * matrix.dims(1) + rows.as(u64));
+
+            return af::sparseConvertTo(
+                af::sparse(
+                    matrix.dims(1),
+                    matrix.dims(0),
+                    af::sparseGetValues(coordinates)(order),
+                    columns(order),
+                    rows(order),
+                    AF_STORAGE_COO),
+                AF_STORAGE_CSR);
+        }
+
+        /// <summary>
+        /// Finds the most disturbed states, largest first.
+        /// </summary>
+        /// <param name="largest">- Receives the priorities of the most disturbed states.</param>
+        /// <param name="states">- Receives the most disturbed states.</param>
+        /// <param name="priority">- How disturbed each state is.</param>
+        /// <param name="k">- How many states to find.</param>
+        void mostDisturbed(
+            af::array& largest,
+            af::array& states,
+            const af::array& priority,
+            dim_t k)
+        {
+            // topk is limited to small k on some backends, past which a full sort is needed.
+            if (k <= TOPK_LIMIT)
+            {
+                af::topk(largest, states, priority, static_cast<int>(k), 0, AF_TOPK_MAX);
+                return;
+            }
+
+            af::array sorted{};
+            af::array byPriority{};
+            af::sort(sorted, byPriority, priority, 0, false);
+
+            largest = sorted(af::seq(0, static_cast<double>(k - 1)));
+            states = byPriority(af::seq(0, static_cast<double>(k - 1)));
+        }
+
+        /// <summary>
+        /// Returns the seconds elapsed since some time.
+        /// </summary>
+        /// <param name="start">- The time to measure from.</param>
+        /// <returns>The seconds elapsed since start.</returns>
+        double secondsSince(std::chrono::steady_clock::time_point start)
+        {
+            return std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count();
+        }
+
+        /// <summary>
+        /// Runs some device work, and when reporting, waits for the device to finish it
+        /// so its time can be charged to it.
+        /// </summary>
+        /// <param name="reporting">- If the work should be timed.</param>
+        /// <param name="seconds">- Where to add the time the work took.</param>
+        /// <param name="work">- The work to run.</param>
+        /// <returns>The result of the work.</returns>
+        template <class TResult>
+        TResult timed(bool reporting, double& seconds, const std::function<TResult()>& work)
+        {
+            if (!reporting)
+            {
+                return work();
+            }
+
+            const auto start{std::chrono::steady_clock::now()};
+
+            TResult result{work()};
+
+            if constexpr (std::is_same_v<TResult, af::array>)
+            {
+                result.eval();
+            }
+            else
+            {
+                result.template unwrap<TResult>().eval();
+            }
+
+            af::sync();
+            seconds += secondsSince(start);
+
+            return result;
+        }
+
+        /// <summary>
+        /// Extrapolates the estimates of a fixed point iteration on the device.
+        /// </summary>
+        class Accelerator
+        {
+        public:
+            /// <summary>
+            /// Creates an Accelerator.
+            /// </summary>
+            /// <param name="acceleration">- How to extrapolate.</param>
+            explicit Accelerator(const Acceleration& acceleration) :
+                m_acceleration{acceleration}
+            {}
+
+            /// <summary>
+            /// Returns the next estimate of the iteration.
+            /// </summary>
+            /// <param name="value">- The current estimate.</param>
+            /// <param name="backedUp">- The current estimate after one backup.</param>
+            /// <returns>The estimate to back up next.</returns>
+            af::array operator()(const af::array& value, const af::array& backedUp)
+            {
+                switch (m_acceleration.method)
+                {
+                case AccelerationMethod::overRelaxation:
+                    return value + m_acceleration.relaxation * (backedUp - value);
+                case AccelerationMethod::anderson:
+                    return anderson(value, backedUp);
+                default:
+                    return backedUp;
+                }
+            }
+
+        private:
+            /// <summary>
+            /// Mixes the last few backups with weights that minimise their combined
+            /// residual, solving the small regularised least squares problem on the
+            /// device. Each variant along dimension 1 gets its own weights, so variants
+            /// don't steer one another's extrapolation.
+            /// </summary>
+            /// <param name="value">- The current estimate.</param>
+            /// <param name="backedUp">- The current estimate after one backup.</param>
+            /// <returns>The estimate to back up next.</returns>
+            af::array anderson(const af::array& value, const af::array& backedUp)
+            {
+                // Histories hold states along dimension 0, past iterations along
+                // dimension 1, and variants along dimension 2.
+                const auto nStates{value.dims(0)};
+                const auto nVariants{value.elements() / nStates};
+                const af::dim4 columns{nStates, 1, nVariants};
+
+                const af::array g{af::moddims(backedUp, columns)};
+                const af::array f{g - af::moddims(value, columns)};
+
+                if (!m_lastResidual.isempty())
+                {
+                    append(m_residualChanges, f - m_lastResidual);
+                    append(m_backupChanges, g - m_lastBackup);
+                }
+
+                m_lastResidual = f;
+                m_lastBackup = g;
+
+                if (m_residualChanges.isempty())
+                {
+                    return backedUp;
+                }
+
+                const auto n{m_residualChanges.dims(1)};
+                const auto gram{
+                    af::matmul(m_residualChanges, m_residualChanges, AF_MAT_TRANS, AF_MAT_NONE)};
+                const auto trace{af::sum(af::sum(m_residualChanges * m_residualChanges, 0), 1)};
+                const auto system{
+                    gram +
+                    af::tile(af::identity(n, n, gram.type()), 1, 1, nVariants) *
+                    af::tile(1e-10 * trace + 1e-30, n, n)};
+                const auto target{
+                    af::matmul(m_residualChanges, f, AF_MAT_TRANS, AF_MAT_NONE)};
+
+                af::array weights{af::constant(0, af::dim4{n, 1, nVariants}, gram.type())};
+                for (const auto variant : std::views::iota(dim_t{0}, nVariants))
+                {
+                    weights(af::span, af::span, variant) = af::solve(
+                        system(af::span, af::span, variant),
+                        target(af::span, af::span, variant));
+                }
+
+                const af::array next{g - af::matmul(m_backupChanges, weights)};
+
+                return af::moddims(
+                    af::select(af::isNaN(next) || af::isInf(next), g, next),
+                    backedUp.dims());
+            }
+
+            /// <summary>
+            /// Appends a column to a history, dropping the oldest column past the depth.
+            /// </summary>
+            /// <param name="history">- The history to append to.</param>
+            /// <param name="column">- The column to append.</param>
+            void append(af::array& history, const af::array& column) const
+            {
+                history = history.isempty() ? column : af::join(1, history, column);
+
+                if (history.dims(1) > std::max<dim_t>(m_acceleration.depth, 1))
+                {
+                    history = history(af::span, af::seq(1, af::end), af::span);
+                }
+
+                history.eval();
+            }
+
+            const Acceleration m_acceleration;
+
+            af::array m_lastResidual{};
+            af::array m_lastBackup{};
+            af::array m_residualChanges{};
+            af::array m_backupChanges{};
+        };
+
+        /// <summary>
+        /// Returns where each point of a finer grid falls along one side of a coarser
+        /// grid, such that the corners of both grids line up.
+        /// </summary>
+        /// <param name="from">- The number of coarse points along the side.</param>
+        /// <param name="to">- The number of fine points along the side.</param>
+        /// <param name="type">- The type of the positions.</param>
+        /// <returns>The coarse position of each fine point.</returns>
+        af::array gridPositions(dim_t from, dim_t to, af::dtype type)
+        {
+            return to > 1
+                ? af::range(af::dim4{to}, 0, type) * (static_cast<double>(from - 1) / (to - 1))
+                : af::constant(0, af::dim4{1}, type);
+        }
+
+        /// <summary>
+        /// Linearly interpolates a state value from one grid of states onto another.
+        /// </summary>
+        /// <param name="stateValue">- The state value on the coarser grid.</param>
+        /// <param name="from">- The shape of the coarser grid.</param>
+        /// <param name="to">- The shape of the finer grid.</param>
+        /// <returns>The state value on the finer grid.</returns>
+        StateValue prolong(const StateValue& stateValue, af::dim4 from, af::dim4 to)
+        {
+            const af::array& value{stateValue.unwrap<StateValue>()};
+            const auto nVariants{value.dims(1)};
+
+            const auto x{gridPositions(from[0], to[0], value.type())};
+
+            if (from[1] == 1 && to[1] == 1)
+            {
+                return StateValue{af::approx1(value, x)};
+            }
+
+            const auto y{gridPositions(from[1], to[1], value.type())};
+
+            return StateValue{
+                af::moddims(
+                    af::approx2(
+                        af::moddims(value, af::dim4{from[0], from[1], nVariants}),
+                        af::tile(x, 1, to[1]),
+                        af::tile(y.T(), to[0])),
+                    af::dim4{to.elements(), nVariants})};
+        }
+
+        /// <summary>
+        /// Runs evaluate's sweeps, also returning which variants converged before the
+        /// sweeps ran out. Takes the same arguments as evaluate, after which variants to
+        /// hold fixed from the start.
+        /// </summary>
+        /// <returns>
+        /// The state value estimate, and a row of which variants are converged or held.
+        /// </returns>
+        [[nodiscard]] std::pair<StateValue, af::array> sweepUntilConverged(
+            const af::array& held,
+            const ActionIndices& actionIndices,
+            const StateValue& initialValue,
+            const detail::ExpectedReturnFn& expectedReturnFn,
+            const detail::ActionReductionFn& actionReductionFn,
+            const detail::ProgressFn<const StateValue&>& progressFn,
+            double threshold,
+            size_t nMaxIterations,
+            unsigned checkInterval,
+            const Acceleration& acceleration,
+            const ReportFn& reportFn)
+        {
+            StateValue newValue{initialValue};
+            StateValue oldValue{};
+
+            using namespace std::literals;
+
+            const bool reporting{static_cast<bool>(reportFn)};
+
+            // Every report needs a residual, so reporting checks convergence every sweep.
+            const auto interval{reporting ? 1U : std::max(checkInterval, 1U)};
+            Accelerator accelerate{acceleration};
+
+            const auto nStates{initialValue.unwrap<StateValue>().dims(0)};
+
+            // Which variants along dimension 1 have converged, and so are held fixed.
+            af::array converged{held};
+
+            bool unconverged{!af::allTrue<bool>(converged)};
+            for (const auto i : std::views::iota(0U, nMaxIterations)
+                | std::views::take_while([&](unsigned) { return unconverged; }))
+            {
+                progressFn(newValue);
+
+                const auto start{std::chrono::steady_clock::now()};
+                IterationReport report{.iteration{i}};
+
+                oldValue = newValue;
+
+                const af::array& old{oldValue.unwrap<StateValue>()};
+                const auto expectedReturn{
+                    timed<af::array>(
+                        reporting,
+                        report.expectedReturnSeconds,
+                        [&] { return expectedReturnFn(actionIndices, newValue); })};
+                const auto reduced{
+                    timed<StateValue>(
+                        reporting,
+                        report.reductionSeconds,
+                        [&] { return actionReductionFn(expectedReturn); })};
+                const af::array backedUp{accelerate(old, reduced.unwrap<StateValue>())};
+
+                newValue = StateValue{
+                    af::select(
+                        af::tile(converged, nStates),
+                        old,
+                        af::moddims(backedUp, old.dims()).as(old.type()))};
+
+                if ((i + 1) % interval == 0)
+                {
+                    const auto change{
+                        af::max(af::abs(old - newValue.unwrap<StateValue>()), 0)};
+
+                    converged = converged || change <= threshold;
+                    unconverged = !af::allTrue<bool>(converged);
+
+                    if (reporting)
+                    {
+                        report.residual = af::max<double>(change);
+                        report.sweepSeconds = secondsSince(start);
+                        report.deviceBytes = deviceBytesInUse();
+
+                        reportFn(report);
+                    }
+                }
+                else
+                {
+                    // Materialise the estimate without a host sync, so the JIT tree
+                    // doesn't grow across unchecked iterations.
+                    newValue.unwrap<StateValue>().eval();
+                }
+            }
+
+            return {newValue, converged};
+        }
+    }
+
+    af::dtype valueType(Precision precision)
+    {
+        return precision == Precision::full ? f64 : f32;
+    }
+
+    [[nodiscard]] StateValue estimateAt(
+        Precision precision,
+        const StateValue& initialValue,
+        double threshold,
+        const detail::EstimateFn& estimateFn)
+    {
+        const StateValue initial{initialValue.unwrap<StateValue>().as(valueType(precision))};
+
+        if (precision != Precision::mixed)
+        {
+            return estimateFn(initial, threshold);
+        }
+
+        const auto rough{estimateFn(initial, std::max(threshold, MIXED_THRESHOLD))};
+
+        return estimateFn(StateValue{rough.unwrap<StateValue>().as(f64)}, threshold);
+    }
+
     [[nodiscard]] StateValue evaluate(
         const ActionIndices& actionIndices,
         const StateValue& initialValue,
@@ -18,46 +483,783 @@ namespace irl::iteration
         const detail::ActionReductionFn& actionReductionFn,
         const detail::ProgressFn<const StateValue&>& progressFn,
         double threshold,
+        size_t nMaxIterations,
+        unsigned checkInterval,
+        const Acceleration& acceleration,
+        const ReportFn& reportFn)
+    {
+        return sweepUntilConverged(
+            af::constant(0, af::dim4{1, initialValue.unwrap<StateValue>().dims(1)}, b8),
+            actionIndices,
+            initialValue,
+            expectedReturnFn,
+            actionReductionFn,
+            progressFn,
+            threshold,
+            nMaxIterations,
+            checkInterval,
+            acceleration,
+            reportFn).first;
+    }
+
+    [[nodiscard]] StateValue evaluateEliminating(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::ExpectedReturnFn& expectedReturnFn,
+        const ActionElimination& actionElimination,
+        const detail::ProgressFn<const StateValue&>& progressFn,
+        double threshold,
+        size_t nMaxIterations,
+        const ReportFn& reportFn)
+    {
+        if (actionElimination.discount >= 1)
+        {
+            throw std::invalid_argument{"Need a discount below 1 to eliminate actions"};
+        }
+
+        af::array actions{actionIndices.unwrap<ActionIndices>()};
+        af::array value{initialValue.unwrap<StateValue>()};
+
+        const auto nStates{value.dims(0)};
+        const bool reporting{static_cast<bool>(reportFn)};
+
+        // A residual of e puts every estimate within e / (1 - discount) of optimal, so
+        // every expected return within discount * e / (1 - discount) of its own optimum.
+        const double margin{
+            2 * actionElimination.discount / (1 - actionElimination.discount)};
+
+        // Which variants along dimension 1 have converged, and so are held fixed.
+        af::array converged{af::constant(0, af::dim4{1, value.dims(1)}, b8)};
+
+        bool unconverged{true};
+        for (const auto i : std::views::iota(0U, nMaxIterations)
+            | std::views::take_while([&](unsigned) { return unconverged; }))
+        {
+            progressFn(StateValue{value});
+
+            const auto start{std::chrono::steady_clock::now()};
+            IterationReport report{.iteration{i}};
+
+            const auto expectedReturn{
+                timed<af::array>(
+                    reporting,
+                    report.expectedReturnSeconds,
+                    [&] { return expectedReturnFn(ActionIndices{actions}, StateValue{value}); })};
+
+            const auto best{
+                timed<af::array>(
+                    reporting,
+                    report.reductionSeconds,
+                    [&] { return af::max(expectedReturn, 2); })};
+
+            const af::array backedUp{
+                af::select(
+                    af::tile(converged, nStates),
+                    value,
+                    af::moddims(best, value.dims()).as(value.type()))};
+
+            const af::array running{!converged};
+            const af::array change{af::max(af::abs(backedUp - value), 0)};
+
+            // Only the variants still running need their actions kept, so the margin
+            // only has to cover their residuals.
+            const double residual{af::max<double>(change * running)};
+
+            converged = converged || change <= threshold;
+            unconverged = !af::allTrue<bool>(converged);
+
+            value = backedUp;
+            value.eval();
+
+            const auto nActions{expectedReturn.dims(2)};
+            const af::array tiledBest{af::tile(best, 1, 1, nActions)};
+
+            // An action stays while any running variant could still prefer it, and the
+            // best action always stays, even where no action has a finite return.
+            const af::array kept{
+                af::anyTrue(
+                    af::tile(running, nStates, 1, nActions) &&
+                    (
+                        tiledBest - expectedReturn <= margin * residual ||
+                        expectedReturn == tiledBest
+                    ),
+                    1)};
+
+            const auto nKept{af::max<unsigned>(af::count(kept, 2))};
+
+            if (nKept < actions.dims(2))
+            {
+                // Sorting moves every state's surviving actions to the front. States with
+                // fewer survivors keep backing up a few eliminated actions, which leaves
+                // their optimal values unchanged.
+                af::array sortedKept{};
+                af::array sortedActions{};
+                af::sort(
+                    sortedKept,
+                    sortedActions,
+                    kept.as(u32),
+                    af::tile(actions, nStates / actions.dims(0)),
+                    2,
+                    false);
+
+                actions = sortedActions(af::span, af::span, af::seq(0, nKept - 1.));
+                actions.eval();
+            }
+
+            if (reporting)
+            {
+                report.residual = af::max<double>(change);
+                report.sweepSeconds = secondsSince(start);
+                report.deviceBytes = deviceBytesInUse();
+
+                reportFn(report);
+            }
+        }
+
+        return StateValue{value};
+    }
+
+    [[nodiscard]] StateValue evaluateMultigrid(
+        std::span<const GridLevel> levels,
+        const StateValue& initialValue,
+        const detail::ActionReductionFn& actionReductionFn,
+        const detail::ProgressFn<const StateValue&>& progressFn,
+        double threshold,
         size_t nMaxIterations)
     {
-        StateValue newValue{initialValue};
-        StateValue oldValue{};
+        if (levels.empty())
+        {
+            throw std::invalid_argument{"Need at least one grid level"};
+        }
+
+        if (std::ranges::any_of(
+            levels,
+            [](const GridLevel& level) { return level.shape[2] != 1 || level.shape[3] != 1; }))
+        {
+            throw std::invalid_argument{"Need grids of at most two dimensions"};
+        }
+
+        if (initialValue.unwrap<StateValue>().dims(0) != levels.front().shape.elements())
+        {
+            throw std::invalid_argument{"Need one initial value per state of the coarsest grid"};
+        }
+
+        StateValue value{initialValue};
+        const GridLevel* coarser{nullptr};
+
+        for (const auto& level : levels)
+        {
+            if (coarser != nullptr)
+            {
+                value = prolong(value, coarser->shape, level.shape);
+            }
+
+            value = evaluate(
+                level.actionIndices,
+                value,
+                level.expectedReturnFn,
+                actionReductionFn,
+                progressFn,
+                threshold,
+                nMaxIterations);
+
+            coarser = &level;
+        }
+
+        return value;
+    }
+
+    [[nodiscard]] StateValue evaluateInPlace(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::StateReturnFn& stateReturnFn,
+        const detail::ActionReductionFn& actionReductionFn,
+        const SweepOrder& sweepOrder,
+        const detail::ProgressFn<const StateValue&>& progressFn,
+        double threshold,
+        size_t nMaxIterations,
+        const ReportFn& reportFn)
+    {
+        const af::array& actions{actionIndices.unwrap<ActionIndices>()};
+        const af::array& order{sweepOrder.order.unwrap<StateIndices>()};
+
+        const bool reporting{static_cast<bool>(reportFn)};
+
+        af::array value{initialValue.unwrap<StateValue>().copy()};
+
+        const bool actionPerState{actions.dims(0) > 1};
+        const dim_t nOrdered{order.elements()};
+        const dim_t blockSize{std::max(dim_t{sweepOrder.blockSize}, dim_t{1})};
 
-        using namespace std::literals;
+        // Which variants along dimension 1 have converged, and so are held fixed.
+        af::array converged{af::constant(0, af::dim4{1, value.dims(1)}, b8)};
 
-        double delta{std::numeric_limits<double>::max()};
+        bool unconverged{true};
         for (const auto i : std::views::iota(0U, nMaxIterations)
-            | std::views::take_while([&](unsigned) { return delta > threshold; }))
+            | std::views::take_while([&](unsigned) { return unconverged; }))
         {
-            progressFn(newValue);
+            progressFn(StateValue{value});
+
+            const auto start{std::chrono::steady_clock::now()};
+            IterationReport report{.iteration{i}};
+
+            const auto oldValue{value.copy()};
+
+            for (dim_t first{0}; first < nOrdered; first += blockSize)
+            {
+                const af::array block{
+                    order(af::seq(
+                        static_cast<double>(first),
+                        static_cast<double>(std::min(first + blockSize, nOrdered) - 1)))};
+
+                const auto stateReturn{
+                    timed<af::array>(
+                        reporting,
+                        report.expectedReturnSeconds,
+                        [&]
+                        {
+                            return stateReturnFn(
+                                StateIndices{block},
+                                ActionIndices{
+                                    actionPerState
+                                        ? af::array{actions(block, af::span, af::span)}
+                                        : actions},
+                                StateValue{value});
+                        })};
+
+                auto backedUp{
+                    timed<StateValue>(
+                        reporting,
+                        report.reductionSeconds,
+                        [&] { return actionReductionFn(stateReturn); }
+                    ).unwrap<StateValue>().as(value.type())};
+
+                backedUp.eval();
+
+                value(block, af::span) = af::select(
+                    af::tile(converged, block.elements()),
+                    oldValue(block, af::span),
+                    af::moddims(backedUp, af::dim4{block.elements(), value.dims(1)}));
+            }
+
+            const af::array change{af::max(af::abs(oldValue - value), 0)};
+
+            converged = converged || change <= threshold;
+            unconverged = !af::allTrue<bool>(converged);
+
+            if (reporting)
+            {
+                report.residual = af::max<double>(change);
+                report.sweepSeconds = secondsSince(start);
+                report.deviceBytes = deviceBytesInUse();
 
-            oldValue = newValue;
-            newValue = actionReductionFn(expectedReturnFn(actionIndices, newValue));
-            delta = af::max<double>(af::abs(oldValue - newValue));
+                reportFn(report);
+            }
         }
 
-        return newValue;
+        return StateValue{value};
+    }
+
+    [[nodiscard]] StateValue evaluatePrioritised(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::StateReturnFn& stateReturnFn,
+        const detail::ActionReductionFn& actionReductionFn,
+        const PrioritySweep& prioritySweep,
+        const detail::ProgressFn<const StateValue&>& progressFn,
+        double threshold,
+        size_t nMaxBatches)
+    {
+        const af::array& actions{actionIndices.unwrap<ActionIndices>()};
+
+        af::array value{initialValue.unwrap<StateValue>().copy()};
+
+        if (value.dims(1) > 1)
+        {
+            throw std::invalid_argument{"Need a single variant to sweep by priority"};
+        }
+
+        const bool actionPerState{actions.dims(0) > 1};
+        const dim_t nStates{value.elements()};
+        const dim_t batchSize{
+            std::clamp(dim_t{prioritySweep.batchSize}, dim_t{1}, nStates)};
+
+        // Row s' of the transposed graph lists the predecessors that s' can disturb.
+        const af::array predecessors{
+            transposeCSR(prioritySweep.transitionGraph.unwrap<TransitionGraph>())};
+        const af::array predecessorOffsets{af::sparseGetRowIdx(predecessors)};
+        const af::array predecessorStates{af::sparseGetColIdx(predecessors)};
+        const af::array predecessorWeights{af::sparseGetValues(predecessors)};
+
+        const auto backup{
+            [&](const af::array& states)
+            {
+                return actionReductionFn(
+                    stateReturnFn(
+                        StateIndices{states},
+                        ActionIndices{
+                            actionPerState
+                                ? af::array{actions(states, af::span, af::span)}
+                                : actions},
+                        StateValue{value})
+                ).unwrap<StateValue>().as(value.type());
+            }};
+
+        // Every state starts out as disturbed as its current Bellman residual.
+        af::array priority{
+            af::abs(backup(af::range(af::dim4{nStates}, 0, u32)) - value)};
+
+        af::array batch{};
+        const auto nextBatch{
+            [&]
+            {
+                af::array largest{};
+                mostDisturbed(largest, batch, priority, batchSize);
+
+                return af::max<double>(largest);
+            }};
+
+        for (size_t i{0}; i < nMaxBatches && nextBatch() > threshold; ++i)
+        {
+            progressFn(StateValue{value});
+
+            auto backedUp{backup(batch)};
+            backedUp.eval();
+
+            const af::array change{af::abs(backedUp - value(batch))};
+
+            value(batch) = backedUp;
+            priority(batch) = 0;
+
+            if (!predecessorStates.isempty())
+            {
+                // Each state's priority bounds its residual, which grows by the sum of every
+                // change its successors make before it's next backed up.
+                const af::array first{predecessorOffsets(batch)};
+                const af::array lengths{predecessorOffsets(batch + 1) - first};
+                const auto width{af::max<int>(lengths)};
+
+                if (width > 0)
+                {
+                    const af::array step{af::range(af::dim4{1, width}, 1, s32)};
+                    const af::array inRow{
+                        af::where(
+                            af::flat(
+                                af::tile(lengths, 1, width) >
+                                af::tile(step, batch.elements())))};
+                    const af::array entries{
+                        af::flat(af::tile(first, 1, width) + af::tile(step, batch.elements()))(
+                            inRow)};
+
+                    af::array sortedStates{};
+                    af::array sortedDisturbances{};
+                    af::sort(
+                        sortedStates,
+                        sortedDisturbances,
+                        predecessorStates(entries),
+                        (predecessorWeights(entries) *
+                            af::flat(af::tile(change, 1, width))(inRow).as(
+                                predecessorWeights.type())));
+
+                    af::array disturbed{};
+                    af::array disturbances{};
+                    af::sumByKey(disturbed, disturbances, sortedStates, sortedDisturbances);
+
+                    priority(disturbed) += disturbances.as(priority.type());
+                }
+            }
+
+            priority.eval();
+        }
+
+        return StateValue{value};
+    }
+
+    [[nodiscard]] StateValue evaluateRealTime(
+        const ActionIndices& actionIndices,
+        const StateValue& initialValue,
+        const detail::StateReturnFn& stateReturnFn,
+        const RealTimeSearch& realTimeSearch,
+        const detail::ProgressFn<const StateValue&>& progressFn,
+        double threshold,
+        size_t nMaxTrials)
+    {
+        const af::array& actions{actionIndices.unwrap<ActionIndices>()};
+        const af::array starts{af::flat(realTimeSearch.startStates.unwrap<StateIndices>())};
+
+        af::array value{initialValue.unwrap<StateValue>().copy()};
+
+        if (actions.dims(0) > 1)
+        {
+            throw std::invalid_argument{"Need actions shared by every state"};
+        }
+
+        if (value.dims(1) > 1)
+        {
+            throw std::invalid_argument{"Need a single variant to search in real time"};
+        }
+
+        if (starts.isempty())
+        {
+            throw std::invalid_argument{"Need at least one start state"};
+        }
+
+        const auto nStates{static_cast<unsigned>(value.dims(0))};
+        const auto nStarts{static_cast<unsigned>(starts.elements())};
+        const af::array flatActions{af::flat(actions).as(u32)};
+
+        // Sampled trials only visit some of the reachable states, so one quiet trial
+        // says little about the rest; only a run of them ends the search.
+        const auto nQuietNeeded{std::max(realTimeSearch.quietTrials, 1U)};
+
+        unsigned nQuiet{0};
+        for (const auto i : std::views::iota(0U, nMaxTrials)
+            | std::views::take_while([&](unsigned) { return nQuiet < nQuietNeeded; }))
+        {
+            progressFn(StateValue{value});
+
+            double residual{0};
+
+            af::array states{
+                starts(
+                    af::min(
+                        (af::randu(realTimeSearch.batchSize) * nStarts).as(u32),
+                        nStarts - 1))};
+
+            for (const auto step : std::views::iota(0U, realTimeSearch.horizon)
+                | std::views::take_while([&](unsigned) { return !states.isempty(); }))
+            {
+                const af::array stateReturn{
+                    stateReturnFn(StateIndices{states}, actionIndices, StateValue{value})};
+
+                af::array best{af::flat(af::max(stateReturn, 2)).as(value.type())};
+                const af::array greedy{math::argMax<2>(stateReturn)};
+
+                best.eval();
+
+                residual = std::max(residual, af::max<double>(af::abs(best - value(states))));
+
+                value(states) = best;
+
+                const af::array next{
+                    af::flat(
+                        realTimeSearch.successorFn(
+                            StateIndices{states},
+                            ActionIndices{flatActions(af::flat(greedy))}
+                        ).unwrap<StateIndices>()).as(u32)};
+
+                const af::array continuing{af::where(next < nStates)};
+
+                states = continuing.isempty() ? af::array{} : af::array{next(continuing)};
+            }
+
+            nQuiet = residual > threshold ? 0 : nQuiet + 1;
+        }
+
+        return StateValue{value};
+    }
+
+    [[nodiscard]] StateValue evaluateNatively(
+        const StateValue& initialValue,
+        const NativeSweep& nativeSweep,
+        double threshold,
+        size_t nMaxSweeps)
+    {
+        const af::array& value{initialValue.unwrap<StateValue>()};
+
+        if (!nativeSweep.engine)
+        {
+            throw std::invalid_argument{"Need an engine to sweep natively"};
+        }
+
+        if (value.dims(1) > 1)
+        {
+            throw std::invalid_argument{"Need a single variant to sweep natively"};
+        }
+
+        auto hostValue{toVector<double>(value.as(f64))};
+
+        hostValue = nativeSweep.asynchronous
+            ? nativeSweep.engine->evaluateOptimalAsynchronously(
+                std::move(hostValue),
+                threshold,
+                nMaxSweeps)
+            : nativeSweep.engine->evaluateOptimal(std::move(hostValue), threshold, nMaxSweeps);
+
+        return StateValue{toArrayFire(hostValue).as(value.type())};
     }
 
     PolicyIteration::PolicyIteration(
         ActionCount nActions,
         StateCount nStates,
         const detail::ExpectedReturnFn& expectedReturnFn,
-        const detail::ProgressFn<>& progressFn
+        const detail::ProgressFn<>& progressFn,
+        const PolicyEvaluation& policyEvaluation
+    ) :
+        PolicyIteration{
+            nActions,
+            nStates,
+            VariantCount{1},
+            expectedReturnFn,
+            progressFn,
+            policyEvaluation}
+    {}
+
+    PolicyIteration::PolicyIteration(
+        ActionCount nActions,
+        StateCount nStates,
+        VariantCount nVariants,
+        const detail::ExpectedReturnFn& expectedReturnFn,
+        const detail::ProgressFn<>& progressFn,
+        const PolicyEvaluation& policyEvaluation
     ) :
         m_allActions{af::range(af::dim4{1, 1, nActions.unwrap<ActionCount>()}, 2, u32)},
-        m_initialState{af::constant(0., nStates.unwrap<StateCount>(), f32)},
+        m_initialState{
+            af::constant(
+                0.,
+                nStates.unwrap<StateCount>(),
+                nVariants.unwrap<VariantCount>(),
+                valueType(policyEvaluation.precision))},
         m_initialPolicy{
             af::constant(
                 std::floor(nActions.unwrap<ActionCount>() / 2),
                 nStates.unwrap<StateCount>(),
+                nVariants.unwrap<VariantCount>(),
                 u32)},
         m_expectedReturnFn{expectedReturnFn},
-        m_progressFn{progressFn}
+        m_progressFn{progressFn},
+        m_policyEvaluation{policyEvaluation}
+    {
+        if (policyEvaluation.method == EvaluationMethod::direct)
+        {
+            throw std::runtime_error{"Can't solve policies directly without a model"};
+        }
+
+        if (policyEvaluation.method == EvaluationMethod::native)
+        {
+            throw std::runtime_error{"Can't evaluate policies natively without a model"};
+        }
+    }
+
+    PolicyIteration::PolicyIteration(
+        const TransitionModel& model,
+        const detail::ProgressFn<>& progressFn,
+        const PolicyEvaluation& policyEvaluation,
+        const PolicyImprovement& policyImprovement
+    ) :
+        m_allActions{af::range(af::dim4{1, 1, model.actions().unwrap<ActionCount>()}, 2, u32)},
+        m_initialState{
+            af::constant(
+                0.,
+                model.states().unwrap<StateCount>(),
+                valueType(policyEvaluation.precision))},
+        m_initialPolicy{
+            af::constant(
+                std::floor(model.actions().unwrap<ActionCount>() / 2),
+                model.states().unwrap<StateCount>(),
+                u32)},
+        m_expectedReturnFn{
+            [model](const ActionIndices& actionIndices, const StateValue& stateValue)
+            {
+                return model.expectedReturn(actionIndices, stateValue);
+            }},
+        m_progressFn{progressFn},
+        m_policyEvaluation{policyEvaluation},
+        m_policyImprovement{policyImprovement},
+        m_model{model},
+        m_transitionGraph{
+            policyImprovement.incremental
+                ? std::optional{model.transitionGraph()}
+                : std::nullopt},
+        m_nativeEngine{
+            policyEvaluation.method == EvaluationMethod::native
+                ? std::make_shared<native::NativeEngine>(native::NativeModel{model})
+                : nullptr}
     {}
 
+    af::array PolicyIteration::evaluatePolicy(
+        const Policy& policy,
+        std::optional<PolicyModel>& chain,
+        StateValue& stateValue,
+        const af::array& finished,
+        size_t limit,
+        const ReportFn& reportFn) const
+    {
+        const bool direct{
+            m_model &&
+            (
+                m_policyEvaluation.method == EvaluationMethod::direct ||
+                (
+                    m_policyEvaluation.method == EvaluationMethod::automatic &&
+                    m_model->states().unwrap<StateCount>() <= m_policyEvaluation.directLimit
+                )
+            )};
+
+        if (direct)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+
+            stateValue = StateValue{
+                m_model->solve(policy).unwrap<StateValue>().as(
+                    m_policyEvaluation.precision == Precision::single ? f32 : f64)};
+
+            if (reportFn)
+            {
+                stateValue.unwrap<StateValue>().eval();
+                af::sync();
+
+                // A direct solve is exact, so it leaves no residual.
+                reportFn(
+                    IterationReport{
+                        .sweepSeconds{secondsSince(start)},
+                        .deviceBytes{deviceBytesInUse()}});
+            }
+
+            return af::constant(1, finished.dims(), b8);
+        }
+
+        if (m_nativeEngine)
+        {
+            const auto start{std::chrono::steady_clock::now()};
+            const auto type{stateValue.unwrap<StateValue>().type()};
+
+            stateValue = StateValue{
+                toArrayFire(
+                    m_nativeEngine->evaluate(
+                        toVector<unsigned>(policy.unwrap<Policy>()),
+                        toVector<double>(stateValue.unwrap<StateValue>().as(f64)),
+                        NATIVE_THRESHOLD,
+                        limit)
+                ).as(type)};
+
+            const auto change{m_nativeEngine->lastChange()};
+
+            if (reportFn)
+            {
+                // Native sweeps run on the host, so only the whole evaluation is timed.
+                reportFn(
+                    IterationReport{
+                        .residual{change},
+                        .sweepSeconds{secondsSince(start)},
+                        .deviceBytes{deviceBytesInUse()}});
+            }
+
+            return af::constant(change <= NATIVE_THRESHOLD, finished.dims(), b8);
+        }
+
+        // Models hold their matrices in single precision, so double precision sweeps
+        // back up through a widened chain: cached with the chain when every sweep needs
+        // it, or made once per evaluation for the polish of a mixed precision one.
+        if (m_model && !chain)
+        {
+            chain = m_model->underPolicy(policy);
+
+            if (m_policyEvaluation.precision == Precision::full)
+            {
+                chain = widened(*chain);
+            }
+        }
+
+        std::optional<PolicyModel> wideChain{};
+
+        const auto expectedReturnFn{
+            chain
+                ? detail::ExpectedReturnFn{
+                    [&](const ActionIndices&, const StateValue& value)
+                    {
+                        const bool narrow{value.unwrap<StateValue>().type() != f64};
+
+                        if (narrow || chain->rewards.type() == f64)
+                        {
+                            return chainReturn(*chain, m_model->discount(), value);
+                        }
+
+                        if (!wideChain)
+                        {
+                            wideChain = widened(*chain);
+                        }
+
+                        return chainReturn(*wideChain, m_model->discount(), value);
+                    }}
+                : m_expectedReturnFn};
+
+        // Both stages of a mixed precision evaluation share one budget of sweeps, of
+        // which the double precision polish is always left at least one.
+        size_t nSweeps{0};
+        af::array converged{finished};
+
+        const auto reserved{
+            [&](const StateValue& initialValue) -> size_t
+            {
+                const bool rough{initialValue.unwrap<StateValue>().type() == f32};
+
+                return m_policyEvaluation.precision == Precision::mixed && rough ? 1 : 0;
+            }};
+
+        stateValue = estimateAt(
+            m_policyEvaluation.precision,
+            stateValue,
+            1e-9,
+            [&](const StateValue& initialValue, double threshold)
+            {
+                StateValue estimate{};
+                std::tie(estimate, converged) = sweepUntilConverged(
+                    finished,
+                    ActionIndices{policy.unwrap<Policy>()},
+                    initialValue,
+                    expectedReturnFn,
+                    [](af::array expectedReturnPerAction)
+                    {
+                        return StateValue{expectedReturnPerAction};
+                    },
+                    [&](const StateValue&) { ++nSweeps; },
+                    threshold,
+                    limit - std::min(nSweeps + reserved(initialValue), limit),
+                    1,
+                    m_policyEvaluation.acceleration,
+                    reportFn);
+
+                return estimate;
+            });
+
+        return converged;
+    }
+
+    IterationReport PolicyIteration::improvementReport(
+        size_t iteration,
+        const Policy& policy,
+        const Policy& newPolicy,
+        const StateValue& lastValue,
+        const StateValue& stateValue,
+        std::chrono::steady_clock::time_point start)
+    {
+        const af::array& actions{newPolicy.unwrap<Policy>()};
+        actions.eval();
+        af::sync();
+
+        const auto seconds{secondsSince(start)};
+
+        const af::array& value{stateValue.unwrap<StateValue>()};
+        const af::array& last{lastValue.unwrap<StateValue>()};
+
+        return IterationReport{
+            .iteration{iteration},
+            .residual{af::max<double>(af::abs(value - last))},
+            .sweepSeconds{seconds},
+            .deviceBytes{deviceBytesInUse()},
+            .policyChanges{af::count<size_t>(policy.unwrap<Policy>() != actions)}};
+    }
+
     Policy PolicyIteration::improve(const StateValue& stateValue) const
     {
+        if (m_nativeEngine)
+        {
+            return Policy{
+                toArrayFire(
+                    m_nativeEngine->improve(
+                        toVector<double>(stateValue.unwrap<StateValue>().as(f64))))};
+        }
+
         return Policy{
             math::argMax<2>(
                 m_expectedReturnFn(
@@ -65,11 +1267,75 @@ namespace irl::iteration
                     stateValue))};
     }
 
+    Policy PolicyIteration::improve(
+        const Policy& policy,
+        const StateValue& stateValue,
+        StateValue& improvedAt) const
+    {
+        const af::array& value{stateValue.unwrap<StateValue>()};
+        af::array& reference{improvedAt.unwrap<StateValue>()};
+
+        if (!m_transitionGraph || reference.isempty())
+        {
+            improvedAt = StateValue{value.copy()};
+
+            return improve(stateValue);
+        }
+
+        const af::array& graph{m_transitionGraph->unwrap<TransitionGraph>()};
+        const af::array moved{af::abs(value - reference) > m_policyImprovement.tolerance};
+
+        // Only states whose successors moved can prefer different actions.
+        const af::array changed{
+            af::where(af::matmul(graph, moved.as(graph.type())) > 0)};
+
+        reference = af::select(moved, value, reference);
+
+        if (changed.isempty())
+        {
+            return policy;
+        }
+
+        af::array actions{policy.unwrap<Policy>().copy()};
+        actions(changed) =
+            math::argMax<2>(
+                m_model->stateReturn(StateIndices{changed}, m_allActions, stateValue)
+            ).as(actions.type());
+
+        return Policy{actions};
+    }
+
     ValueIteration::ValueIteration(
         ActionCount nActions,
-        StateCount nStates
+        StateCount nStates,
+        VariantCount nVariants,
+        Precision precision,
+        const ActionElimination& actionElimination
     ) :
         m_allActions{af::range(af::dim4{1, 1, nActions.unwrap<ActionCount>()}, 2, u32)},
-        m_initialState{af::constant(0, nStates.unwrap<StateCount>(), f64)}
+        m_allStates{af::range(af::dim4{nStates.unwrap<StateCount>()}, 0, u32)},
+        m_initialState{
+            af::constant(
+                0,
+                nStates.unwrap<StateCount>(),
+                nVariants.unwrap<VariantCount>(),
+                valueType(precision))},
+        m_precision{precision},
+        m_actionElimination{actionElimination}
     {}
+
+    StateValue ValueIteration::maxAction(const af::array& expectedReturnPerAction)
+    {
+        return StateValue{af::max(expectedReturnPerAction, 2)};
+    }
+
+    Policy ValueIteration::nativeGreedy(
+        const NativeSweep& nativeSweep,
+        const StateValue& stateValue)
+    {
+        return Policy{
+            toArrayFire(
+                nativeSweep.engine->improve(
+                    toVector<double>(stateValue.unwrap<StateValue>().as(f64))))};
+    }
 }
\ No newline at end of file
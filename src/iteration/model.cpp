@@ -0,0 +1,706 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <arrayfire.h>
+
+#include "introRL/afUtils.hpp"
+#include "introRL/mappedFile.hpp"
+#include "introRL/types.hpp"
+#include "introRL/iteration/model.hpp"
+#include "introRL/iteration/types.hpp"
+
+namespace irl::iteration
+{
+    namespace
+    {
+        constexpr std::uint64_t MODEL_ALIGNMENT{64};
+        constexpr std::uint64_t FNV_OFFSET_BASIS{14'695'981'039'346'656'037ULL};
+        constexpr std::uint64_t FNV_PRIME{1'099'511'628'211ULL};
+
+        /// <summary>
+        /// Returns the start of a section of a mapped model file.
+        /// </summary>
+        /// <typeparam name="T">The type of the section's elements.</typeparam>
+        /// <param name="bytes">- The mapped model file.</param>
+        /// <param name="offset">- The offset of the section in bytes.</param>
+        /// <returns>The first element of the section.</returns>
+        template <class T>
+        const T* section(std::span<const std::byte> bytes, std::uint64_t offset)
+        {
+            return reinterpret_cast<const T*>(bytes.data() + offset);
+        }
+
+        /// <summary>
+        /// Returns whether a section of some number of elements lies, aligned, inside a
+        /// mapped model file.
+        /// </summary>
+        /// <typeparam name="T">The type of the section's elements.</typeparam>
+        /// <param name="bytes">- The mapped model file.</param>
+        /// <param name="offset">- The offset of the section in bytes.</param>
+        /// <param name="count">- The number of elements in the section.</param>
+        /// <returns>True if the whole section can be read from the file.</returns>
+        template <class T>
+        bool fits(std::span<const std::byte> bytes, std::uint64_t offset, std::uint64_t count)
+        {
+            return
+                offset % alignof(T) == 0 &&
+                offset <= bytes.size() &&
+                count <= (bytes.size() - offset) / sizeof(T);
+        }
+
+        /// <summary>
+        /// Returns whether some offsets start at zero, never decrease, and end at a total.
+        /// </summary>
+        /// <typeparam name="T">The type of the offsets.</typeparam>
+        /// <param name="offsets">- The offsets to check.</param>
+        /// <param name="total">- The offset the last one should equal.</param>
+        /// <returns>True if the offsets describe consecutive runs covering the total.</returns>
+        template <class T>
+        bool partitions(std::span<const T> offsets, std::uint64_t total)
+        {
+            return
+                !offsets.empty() &&
+                offsets.front() == 0 &&
+                std::ranges::is_sorted(offsets) &&
+                static_cast<std::uint64_t>(offsets.back()) == total;
+        }
+
+        /// <summary>
+        /// Returns whether every section described by a model header lies inside a mapped
+        /// model file and indexes only entries that exist.
+        /// </summary>
+        /// <param name="bytes">- The mapped model file.</param>
+        /// <param name="header">- The header read from the start of the file.</param>
+        /// <returns>True if the model can be read from the file without overruns.</returns>
+        bool validLayout(std::span<const std::byte> bytes, const ModelHeader& header)
+        {
+            const std::uint64_t nActions{header.nActions};
+            const std::uint64_t nStates{header.nStates};
+            const auto nEntries{header.nEntries};
+            const auto nRows{nStates + 1};
+
+            if (
+                !fits<std::uint64_t>(bytes, header.entryOffsetsOffset, nActions + 1) ||
+                !fits<int>(bytes, header.rowOffsetsOffset, nActions * nRows) ||
+                !fits<int>(bytes, header.columnsOffset, nEntries) ||
+                !fits<float>(bytes, header.probabilitiesOffset, nEntries) ||
+                !fits<float>(bytes, header.rewardsOffset, nActions * nStates))
+            {
+                return false;
+            }
+
+            const std::span entryOffsets{
+                section<std::uint64_t>(bytes, header.entryOffsetsOffset),
+                nActions + 1};
+
+            if (!partitions(entryOffsets, nEntries))
+            {
+                return false;
+            }
+
+            const std::span rowOffsets{
+                section<int>(bytes, header.rowOffsetsOffset),
+                nActions * nRows};
+
+            for (const auto action : std::views::iota(std::uint64_t{0}, nActions))
+            {
+                if (!partitions(
+                    rowOffsets.subspan(action * nRows, nRows),
+                    entryOffsets[action + 1] - entryOffsets[action]))
+                {
+                    return false;
+                }
+            }
+
+            return std::ranges::all_of(
+                std::span{section<int>(bytes, header.columnsOffset), nEntries},
+                [&](int column)
+                {
+                    return column >= 0 && static_cast<std::uint64_t>(column) < nStates;
+                });
+        }
+
+        /// <summary>
+        /// Builds a square sparse (CSR) matrix from sorted, unique linear coordinates.
+        /// </summary>
+        /// <param name="nStates">- The number of rows and columns in the matrix.</param>
+        /// <param name="keys">- Linear coordinates, row major, of each entry.</param>
+        /// <param name="values">- The value of each entry.</param>
+        /// <returns>A sparse matrix holding the values at their coordinates.</returns>
+        af::array toCSR(unsigned nStates, const af::array& keys, const af::array& values)
+        {
+            return af::sparseConvertTo(
+                af::sparse(
+                    nStates,
+                    nStates,
+                    values,
+                    (keys / nStates).as(s32),
+                    (keys % nStates).as(s32),
+                    AF_STORAGE_COO),
+                AF_STORAGE_CSR);
+        }
+    }
+
+    std::uint64_t parameterHash(std::span<const double> parameters)
+    {
+        std::uint64_t hash{FNV_OFFSET_BASIS};
+
+        for (const auto byte : std::as_bytes(parameters))
+        {
+            hash = (hash ^ std::to_integer<std::uint64_t>(byte)) * FNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    TransitionModel::TransitionModel(
+        ActionCount nActions,
+        StateCount nStates,
+        double discount,
+        const TransitionsFn& transitionsFn
+    ) :
+        m_nActions{nActions.unwrap<ActionCount>()},
+        m_nStates{nStates.unwrap<StateCount>()},
+        m_discount{discount}
+    {
+        if (std::uint64_t{m_nStates} * m_nStates > std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::runtime_error{"Can't key transitions between this many states"};
+        }
+
+        for (const auto action : std::views::iota(0U, m_nActions))
+        {
+            const auto transitions{transitionsFn(action)};
+
+            if (transitions.reward.elements() != m_nStates)
+            {
+                throw std::runtime_error{"Need one reward per state"};
+            }
+
+            if (m_rewards.isempty())
+            {
+                m_rewards = af::constant(
+                    0,
+                    af::dim4{m_nStates, 1, m_nActions},
+                    transitions.reward.type());
+            }
+
+            m_rewards(af::span, af::span, action) = af::flat(transitions.reward);
+
+            if (transitions.from.isempty())
+            {
+                m_matrices.emplace_back();
+                continue;
+            }
+
+            af::array sortedKeys{};
+            af::array order{};
+            af::sort(
+                sortedKeys,
+                order,
+                af::flat(transitions.from).as(u32) * m_nStates +
+                    af::flat(transitions.to).as(u32));
+
+            af::array uniqueKeys{};
+            af::array summed{};
+            af::sumByKey(
+                uniqueKeys,
+                summed,
+                sortedKeys,
+                af::flat(transitions.probability)(order));
+
+            m_matrices.push_back(toCSR(m_nStates, uniqueKeys, summed));
+
+            appendEntries(action, uniqueKeys, summed);
+
+            af::eval(m_rewards, m_keys, m_probabilities, m_actions);
+        }
+    }
+
+    TransitionModel::TransitionModel(unsigned nActions, unsigned nStates, double discount) :
+        m_nActions{nActions},
+        m_nStates{nStates},
+        m_discount{discount}
+    {}
+
+    std::optional<TransitionModel> TransitionModel::load(
+        const std::filesystem::path& path,
+        std::uint64_t parameterHash)
+    {
+        if (!std::filesystem::exists(path))
+        {
+            return std::nullopt;
+        }
+
+        const MappedFile file{path, MappedFile::Access::read};
+        const auto bytes{file.bytes()};
+
+        ModelHeader header{};
+        if (bytes.size() < sizeof(header))
+        {
+            return std::nullopt;
+        }
+
+        std::memcpy(&header, bytes.data(), sizeof(header));
+
+        if (
+            header.magic != ModelHeader::MAGIC ||
+            header.version != ModelHeader::VERSION ||
+            header.parameterHash != parameterHash ||
+            !validLayout(bytes, header))
+        {
+            return std::nullopt;
+        }
+
+        const auto nActions{header.nActions};
+        const auto nStates{header.nStates};
+
+        const auto entryOffsets{section<std::uint64_t>(bytes, header.entryOffsetsOffset)};
+        const auto rowOffsets{section<int>(bytes, header.rowOffsetsOffset)};
+        const auto columns{section<int>(bytes, header.columnsOffset)};
+        const auto probabilities{section<float>(bytes, header.probabilitiesOffset)};
+        const auto rewards{section<float>(bytes, header.rewardsOffset)};
+
+        TransitionModel result{nActions, nStates, header.discount};
+
+        result.m_rewards = af::moddims(
+            af::array{af::dim4{nStates, nActions}, rewards, afHost},
+            af::dim4{nStates, 1, nActions});
+
+        for (const auto action : std::views::iota(0U, nActions))
+        {
+            const auto first{entryOffsets[action]};
+            const auto nEntries{static_cast<dim_t>(entryOffsets[action + 1] - first)};
+
+            if (nEntries == 0)
+            {
+                result.m_matrices.emplace_back();
+                continue;
+            }
+
+            const auto matrix{
+                af::sparse(
+                    nStates,
+                    nStates,
+                    nEntries,
+                    probabilities + first,
+                    rowOffsets + std::uint64_t{action} * (nStates + 1),
+                    columns + first,
+                    f32,
+                    AF_STORAGE_CSR,
+                    afHost)};
+
+            const auto coordinates{af::sparseConvertTo(matrix, AF_STORAGE_COO)};
+
+            result.appendEntries(
+                action,
+                af::sparseGetRowIdx(coordinates).as(u32) * nStates +
+                    af::sparseGetColIdx(coordinates).as(u32),
+                af::sparseGetValues(coordinates));
+
+            result.m_matrices.push_back(matrix);
+        }
+
+        af::eval(result.m_rewards, result.m_keys, result.m_probabilities, result.m_actions);
+
+        return result;
+    }
+
+    void TransitionModel::save(
+        const std::filesystem::path& path,
+        std::uint64_t parameterHash) const
+    {
+        std::vector<std::uint64_t> entryOffsets{0};
+        std::vector<int> rowOffsets{};
+        std::vector<int> columns{};
+        std::vector<float> probabilities{};
+
+        rowOffsets.reserve(size_t{m_nActions} * (m_nStates + 1));
+
+        const auto appendHost{
+            [](auto& to, const af::array& from)
+            {
+                const auto size{to.size()};
+                to.resize(size + from.elements());
+                from.host(to.data() + size);
+            }};
+
+        for (const auto& matrix : m_matrices)
+        {
+            if (matrix.isempty())
+            {
+                rowOffsets.insert(rowOffsets.end(), m_nStates + 1, 0);
+            }
+            else
+            {
+                appendHost(rowOffsets, af::sparseGetRowIdx(matrix).as(s32));
+                appendHost(columns, af::sparseGetColIdx(matrix).as(s32));
+                appendHost(probabilities, af::sparseGetValues(matrix).as(f32));
+            }
+
+            entryOffsets.push_back(columns.size());
+        }
+
+        const auto aligned{
+            [](std::uint64_t offset)
+            {
+                return (offset + MODEL_ALIGNMENT - 1) / MODEL_ALIGNMENT * MODEL_ALIGNMENT;
+            }};
+
+        ModelHeader header{
+            .nActions{m_nActions},
+            .nStates{m_nStates},
+            .discount{m_discount},
+            .parameterHash{parameterHash},
+            .nEntries{columns.size()}};
+
+        header.entryOffsetsOffset = aligned(sizeof(header));
+        header.rowOffsetsOffset =
+            aligned(header.entryOffsetsOffset + entryOffsets.size() * sizeof(std::uint64_t));
+        header.columnsOffset =
+            aligned(header.rowOffsetsOffset + rowOffsets.size() * sizeof(int));
+        header.probabilitiesOffset =
+            aligned(header.columnsOffset + columns.size() * sizeof(int));
+        header.rewardsOffset =
+            aligned(header.probabilitiesOffset + probabilities.size() * sizeof(float));
+
+        const auto rewards{toVector<float>(af::flat(m_rewards).as(f32))};
+
+        MappedFile file{path, MappedFile::Access::write};
+        file.resize(header.rewardsOffset + rewards.size() * sizeof(float));
+
+        auto bytes{file.bytes()};
+
+        const auto write{
+            [&](std::uint64_t offset, const auto& values)
+            {
+                std::memcpy(
+                    bytes.data() + offset,
+                    values.data(),
+                    values.size() * sizeof(values[0]));
+            }};
+
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        write(header.entryOffsetsOffset, entryOffsets);
+        write(header.rowOffsetsOffset, rowOffsets);
+        write(header.columnsOffset, columns);
+        write(header.probabilitiesOffset, probabilities);
+        write(header.rewardsOffset, rewards);
+
+        file.flush();
+    }
+
+    af::array TransitionModel::expectedReturn(
+        const ActionIndices& actionIndices,
+        const StateValue& stateValue) const
+    {
+        const af::array& actions{actionIndices.unwrap<ActionIndices>()};
+        const af::array& value{stateValue.unwrap<StateValue>()};
+
+        if (actions.dims(0) > 1)
+        {
+            af::array result{af::constant(0, m_nStates, value.type())};
+
+            for (const auto action : std::views::iota(0U, m_nActions))
+            {
+                const auto chosen{actions == action};
+
+                if (af::anyTrue<bool>(chosen))
+                {
+                    result = af::select(chosen, backup(action, value), result);
+                }
+            }
+
+            return result;
+        }
+
+        std::vector<unsigned> hostActions(actions.elements());
+        actions.as(u32).host(hostActions.data());
+
+        af::array result{
+            af::constant(
+                0,
+                af::dim4{m_nStates, 1, static_cast<dim_t>(hostActions.size())},
+                value.type())};
+
+        for (auto&& [i, action] : std::views::enumerate(hostActions))
+        {
+            result(af::span, af::span, i) = backup(action, value);
+        }
+
+        return result;
+    }
+
+    af::array TransitionModel::stateReturn(
+        const StateIndices& stateIndices,
+        const ActionIndices& actionIndices,
+        const StateValue& stateValue) const
+    {
+        const af::array states{af::flat(stateIndices.unwrap<StateIndices>()).as(u32)};
+        const af::array& actions{actionIndices.unwrap<ActionIndices>()};
+        const af::array value{af::flat(stateValue.unwrap<StateValue>())};
+
+        const auto nChosen{states.elements()};
+        const bool actionPerState{actions.dims(0) > 1};
+        const auto nColumns{actionPerState ? dim_t{1} : actions.elements()};
+
+        // Where each state sits in the result, or -1 if it wasn't asked for.
+        af::array position{af::constant(-1, m_nStates, s32)};
+        position(states) = af::range(af::dim4{nChosen}, 0, s32);
+
+        const af::array rewardKeys{
+            actionPerState
+                ? af::array{states + m_nStates * af::flat(actions).as(u32)}
+                : af::array{
+                    af::flat(
+                        af::tile(states, 1, nColumns) +
+                        m_nStates *
+                            af::tile(af::moddims(actions.as(u32), 1, nColumns), nChosen))}};
+
+        af::array result{af::flat(m_rewards)(rewardKeys).as(value.type())};
+
+        if (!m_keys.isempty())
+        {
+            const af::array from{(m_keys / m_nStates).as(u32)};
+            const af::array row{position(from)};
+
+            // Which column of the result each transition lands in, or -1 if its action
+            // wasn't asked for.
+            af::array column{};
+            if (actionPerState)
+            {
+                af::array chosenAction{af::constant(m_nActions, m_nStates, u32)};
+                chosenAction(states) = af::flat(actions).as(u32);
+
+                column = (chosenAction(from) == m_actions).as(s32) - 1;
+            }
+            else
+            {
+                af::array slot{af::constant(-1, m_nActions, s32)};
+                slot(af::flat(actions).as(u32)) = af::range(af::dim4{nColumns}, 0, s32);
+
+                column = slot(m_actions);
+            }
+
+            const af::array kept{af::where(row >= 0 && column >= 0)};
+
+            if (!kept.isempty())
+            {
+                af::array sortedTargets{};
+                af::array sortedContributions{};
+                af::sort(
+                    sortedTargets,
+                    sortedContributions,
+                    (row(kept) + nChosen * column(kept)).as(u32),
+                    m_probabilities(kept) *
+                        value(m_keys(kept) % m_nStates).as(m_probabilities.type()));
+
+                af::array targets{};
+                af::array sums{};
+                af::sumByKey(targets, sums, sortedTargets, sortedContributions);
+
+                result(targets) += (m_discount * sums).as(value.type());
+            }
+        }
+
+        return af::moddims(result, af::dim4{nChosen, 1, nColumns});
+    }
+
+    PolicyModel TransitionModel::underPolicy(const Policy& policy) const
+    {
+        const af::array actions{af::flat(policy.unwrap<Policy>()).as(u32)};
+        const af::array states{af::range(af::dim4{m_nStates}, 0, u32)};
+
+        PolicyModel result{
+            .rewards{af::flat(m_rewards)(states + m_nStates * actions)}};
+
+        if (m_keys.isempty())
+        {
+            return result;
+        }
+
+        const af::array chosen{af::where(m_actions == actions(m_keys / m_nStates))};
+
+        if (chosen.isempty())
+        {
+            return result;
+        }
+
+        af::array sortedKeys{};
+        af::array order{};
+        af::sort(sortedKeys, order, m_keys(chosen));
+
+        result.transitions = toCSR(m_nStates, sortedKeys, m_probabilities(chosen)(order));
+
+        return result;
+    }
+
+    StateIndices TransitionModel::sample(
+        const StateIndices& stateIndices,
+        const ActionIndices& actionIndices) const
+    {
+        const af::array states{af::flat(stateIndices.unwrap<StateIndices>()).as(s32)};
+        const af::array actions{af::flat(actionIndices.unwrap<ActionIndices>()).as(u32)};
+
+        if (states.elements() != actions.elements())
+        {
+            throw std::invalid_argument{"Need one action per sampled state"};
+        }
+
+        const af::array draw{af::randu(states.elements())};
+
+        af::array next{af::constant(m_nStates, states.elements(), u32)};
+
+        for (const auto action : std::views::iota(0U, m_nActions))
+        {
+            const auto& matrix{m_matrices[action]};
+            const af::array chosen{af::where(actions == action)};
+
+            if (matrix.isempty() || chosen.isempty())
+            {
+                continue;
+            }
+
+            const af::array rowOffsets{af::sparseGetRowIdx(matrix)};
+            const af::array columns{af::sparseGetColIdx(matrix)};
+            const af::array probabilities{af::sparseGetValues(matrix)};
+
+            const af::array from{states(chosen)};
+            const af::array first{rowOffsets(from)};
+            const af::array lengths{rowOffsets(from + 1) - first};
+            const auto width{af::max<int>(lengths)};
+
+            if (width == 0)
+            {
+                continue;
+            }
+
+            const auto nChosen{chosen.elements()};
+            const auto lastEntry{static_cast<int>(probabilities.elements()) - 1};
+
+            // Each sample's row of entries, padded out to the longest row with zeros.
+            const af::array step{af::range(af::dim4{1, width}, 1, s32)};
+            const af::array entries{af::tile(first, 1, width) + af::tile(step, nChosen)};
+            const af::array padded{
+                af::select(
+                    af::tile(lengths, 1, width) > af::tile(step, nChosen),
+                    af::moddims(
+                        probabilities(af::flat(af::min(entries, lastEntry))),
+                        entries.dims()),
+                    0.)};
+
+            // Each sample lands on the first entry whose cumulative probability passes its
+            // draw, which is past the end of its row if the row's probabilities run out.
+            const af::array landed{
+                af::count(
+                    af::accum(padded, 1) <=
+                        af::tile(draw(chosen).as(probabilities.type()), 1, width),
+                    1).as(s32)};
+
+            next(chosen) = af::select(
+                landed >= lengths,
+                static_cast<double>(m_nStates),
+                columns(af::min(first + landed, lastEntry)).as(u32));
+        }
+
+        return StateIndices{next};
+    }
+
+    StateValue TransitionModel::solve(const Policy& policy) const
+    {
+        const auto chain{underPolicy(policy)};
+
+        af::array system{af::identity(m_nStates, m_nStates, f64)};
+
+        if (!chain.transitions.isempty())
+        {
+            system -= m_discount * af::dense(chain.transitions).as(f64);
+        }
+
+        return StateValue{af::solve(system, chain.rewards.as(f64))};
+    }
+
+    TransitionGraph TransitionModel::transitionGraph() const
+    {
+        if (m_keys.isempty())
+        {
+            throw std::runtime_error{"Can't make a transition graph without transitions"};
+        }
+
+        af::array sortedKeys{};
+        af::array order{};
+        af::sort(sortedKeys, order, m_keys);
+
+        af::array uniqueKeys{};
+        af::array largest{};
+        af::maxByKey(uniqueKeys, largest, sortedKeys, m_probabilities(order));
+
+        return TransitionGraph{toCSR(m_nStates, uniqueKeys, m_discount * largest)};
+    }
+
+    const af::array& TransitionModel::matrix(unsigned action) const
+    {
+        return m_matrices[action];
+    }
+
+    const af::array& TransitionModel::rewards() const
+    {
+        return m_rewards;
+    }
+
+    ActionCount TransitionModel::actions() const
+    {
+        return ActionCount{m_nActions};
+    }
+
+    StateCount TransitionModel::states() const
+    {
+        return StateCount{m_nStates};
+    }
+
+    double TransitionModel::discount() const
+    {
+        return m_discount;
+    }
+
+    void TransitionModel::appendEntries(
+        unsigned action,
+        const af::array& keys,
+        const af::array& probabilities)
+    {
+        const auto append{
+            [](af::array& to, const af::array& more)
+            {
+                to = to.isempty() ? more : af::join(0, to, more);
+            }};
+
+        append(m_keys, keys);
+        append(m_probabilities, probabilities);
+        append(m_actions, af::constant(action, keys.elements(), u32));
+    }
+
+    af::array TransitionModel::backup(unsigned action, const af::array& value) const
+    {
+        const auto& matrix{m_matrices[action]};
+        const af::array reward{m_rewards(af::span, af::span, action)};
+
+        if (matrix.isempty())
+        {
+            return reward.as(value.type());
+        }
+
+        return (
+            reward +
+            m_discount * af::matmul(matrix, af::flat(value).as(matrix.type()))
+        ).as(value.type());
+    }
+}
\ No newline at end of file
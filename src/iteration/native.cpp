@@ -0,0 +1,519 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arrayfire.h>
+
+#include "introRL/afUtils.hpp"
+#include "introRL/iteration/model.hpp"
+#include "introRL/iteration/native.hpp"
+
+namespace irl::iteration::native
+{
+    namespace
+    {
+        // How often the monitor of an asynchronous estimate checks on its partitions.
+        // Every thread of the pool is already busy backing up states, so the monitor
+        // sleeps between checks rather than competing with them for a core.
+        constexpr std::chrono::microseconds MONITOR_INTERVAL{200};
+    }
+
+    WorkerPool::WorkerPool(unsigned nThreads)
+    {
+        // The thread that starts a loop runs tasks too.
+        const auto nWorkers{std::max(nThreads, 1U) - 1};
+
+        m_threads.reserve(nWorkers);
+        while (m_threads.size() < nWorkers)
+        {
+            m_threads.emplace_back([this] { work(); });
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_stopping = true;
+        }
+
+        m_started.notify_all();
+
+        for (auto& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::forEach(size_t nTasks, const std::function<void(size_t)>& task)
+    {
+        {
+            std::scoped_lock lock{m_mutex};
+            m_task = &task;
+            m_nTasks = nTasks;
+            m_next = 0;
+            m_busy = static_cast<unsigned>(m_threads.size());
+            ++m_generation;
+        }
+
+        m_started.notify_all();
+
+        runTasks();
+
+        std::unique_lock lock{m_mutex};
+        m_finished.wait(lock, [this] { return m_busy == 0; });
+
+        m_task = nullptr;
+
+        if (m_error)
+        {
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+        }
+    }
+
+    unsigned WorkerPool::threads() const
+    {
+        return static_cast<unsigned>(m_threads.size()) + 1;
+    }
+
+    void WorkerPool::work()
+    {
+        std::uint64_t seen{0};
+
+        for (;;)
+        {
+            {
+                std::unique_lock lock{m_mutex};
+                m_started.wait(lock, [&] { return m_stopping || m_generation != seen; });
+
+                if (m_stopping)
+                {
+                    return;
+                }
+
+                seen = m_generation;
+            }
+
+            runTasks();
+
+            std::scoped_lock lock{m_mutex};
+            if (--m_busy == 0)
+            {
+                m_finished.notify_one();
+            }
+        }
+    }
+
+    void WorkerPool::runTasks()
+    {
+        for (size_t i{m_next++}; i < m_nTasks; i = m_next++)
+        {
+            try
+            {
+                (*m_task)(i);
+            }
+            catch (...)
+            {
+                std::scoped_lock lock{m_mutex};
+                m_error = std::current_exception();
+                m_next = m_nTasks;
+            }
+        }
+    }
+
+    NativeModel::NativeModel(const TransitionModel& model) :
+        m_nActions{model.actions().unwrap<ActionCount>()},
+        m_nStates{model.states().unwrap<StateCount>()},
+        m_discount{model.discount()}
+    {
+        struct HostCSR
+        {
+            std::vector<int> rowOffsets;
+            std::vector<int> columns;
+            std::vector<float> probabilities;
+        };
+
+        const auto matrices{
+            std::views::iota(0U, m_nActions)
+            | std::views::transform(
+                [&](unsigned action)
+                {
+                    const auto& matrix{model.matrix(action)};
+
+                    if (matrix.isempty())
+                    {
+                        return HostCSR{.rowOffsets{std::vector<int>(m_nStates + 1, 0)}};
+                    }
+
+                    return HostCSR{
+                        .rowOffsets{toVector<int>(af::sparseGetRowIdx(matrix).as(s32))},
+                        .columns{toVector<int>(af::sparseGetColIdx(matrix).as(s32))},
+                        .probabilities{toVector<float>(af::sparseGetValues(matrix).as(f32))}};
+                })
+            | std::ranges::to<std::vector>()};
+
+        const auto rewards{toVector<double>(af::flat(model.rewards()).as(f64))};
+        const auto nRows{size_t{m_nStates} * m_nActions};
+
+        m_rewards.resize(nRows);
+        m_rowOffsets.resize(nRows + 1);
+
+        for (const auto state : std::views::iota(0U, m_nStates))
+        {
+            for (const auto action : std::views::iota(0U, m_nActions))
+            {
+                const auto& csr{matrices[action]};
+                const auto row{size_t{state} * m_nActions + action};
+                const auto first{static_cast<size_t>(csr.rowOffsets[state])};
+                const auto last{static_cast<size_t>(csr.rowOffsets[state + 1])};
+
+                m_rewards[row] = rewards[state + size_t{m_nStates} * action];
+
+                m_columns.insert(
+                    m_columns.end(),
+                    csr.columns.begin() + first,
+                    csr.columns.begin() + last);
+                m_probabilities.insert(
+                    m_probabilities.end(),
+                    csr.probabilities.begin() + first,
+                    csr.probabilities.begin() + last);
+
+                m_rowOffsets[row + 1] = static_cast<std::uint32_t>(m_columns.size());
+            }
+        }
+    }
+
+    double NativeModel::backup(
+        unsigned state,
+        unsigned action,
+        std::span<const double> value) const
+    {
+        const auto row{size_t{state} * m_nActions + action};
+        const auto first{m_rowOffsets[row]};
+        const auto last{m_rowOffsets[row + 1]};
+
+        return m_rewards[row] + m_discount * std::transform_reduce(
+            std::execution::unseq,
+            m_probabilities.begin() + first,
+            m_probabilities.begin() + last,
+            m_columns.begin() + first,
+            0.,
+            std::plus<>{},
+            [&](float probability, std::uint32_t column)
+            {
+                return probability * value[column];
+            });
+    }
+
+    double NativeModel::backupShared(
+        unsigned state,
+        unsigned action,
+        std::span<double> value) const
+    {
+        const auto row{size_t{state} * m_nActions + action};
+        const auto first{m_rowOffsets[row]};
+        const auto last{m_rowOffsets[row + 1]};
+
+        return m_rewards[row] + m_discount * std::transform_reduce(
+            m_probabilities.begin() + first,
+            m_probabilities.begin() + last,
+            m_columns.begin() + first,
+            0.,
+            std::plus<>{},
+            [&](float probability, std::uint32_t column)
+            {
+                return
+                    probability *
+                    std::atomic_ref{value[column]}.load(std::memory_order_relaxed);
+            });
+    }
+
+    unsigned NativeModel::actions() const
+    {
+        return m_nActions;
+    }
+
+    unsigned NativeModel::states() const
+    {
+        return m_nStates;
+    }
+
+    NativeEngine::NativeEngine(NativeModel model, unsigned nThreads, unsigned tileSize) :
+        m_model{std::move(model)},
+        m_tileSize{std::max(tileSize, 1U)},
+        m_pool{nThreads}
+    {}
+
+    std::vector<double> NativeEngine::evaluate(
+        std::span<const unsigned> policy,
+        std::vector<double> initialValue,
+        double threshold,
+        size_t nMaxSweeps)
+    {
+        if (policy.size() != m_model.states())
+        {
+            throw std::invalid_argument{"Need one action per state"};
+        }
+
+        return sweep(
+            [&](unsigned state, std::span<const double> value)
+            {
+                return m_model.backup(state, policy[state], value);
+            },
+            std::move(initialValue),
+            threshold,
+            nMaxSweeps);
+    }
+
+    std::vector<double> NativeEngine::evaluateOptimal(
+        std::vector<double> initialValue,
+        double threshold,
+        size_t nMaxSweeps)
+    {
+        return sweep(
+            [&](unsigned state, std::span<const double> value)
+            {
+                double best{-std::numeric_limits<double>::infinity()};
+
+                for (const auto action : std::views::iota(0U, m_model.actions()))
+                {
+                    best = std::max(best, m_model.backup(state, action, value));
+                }
+
+                return best;
+            },
+            std::move(initialValue),
+            threshold,
+            nMaxSweeps);
+    }
+
+    std::vector<double> NativeEngine::evaluateOptimalAsynchronously(
+        std::vector<double> initialValue,
+        double threshold,
+        size_t nMaxSweeps)
+    {
+        if (initialValue.size() != m_model.states())
+        {
+            throw std::invalid_argument{"Need one value per state"};
+        }
+
+        // Each partition's latest pass, on its own cache line so that publishing it
+        // doesn't slow down the other partitions.
+        struct alignas(64) PartitionProgress
+        {
+            std::atomic<double> change{std::numeric_limits<double>::infinity()};
+            std::atomic<size_t> passes{0};
+        };
+
+        std::vector<double> value{std::move(initialValue)};
+
+        const auto nStates{size_t{m_model.states()}};
+        const auto nPartitions{size_t{m_pool.threads()}};
+
+        std::vector<PartitionProgress> progress(nPartitions);
+        std::atomic<bool> stopping{false};
+
+        {
+            std::jthread monitor{
+                [&](std::stop_token stopToken)
+                {
+                    while (!stopToken.stop_requested() && !stopping)
+                    {
+                        const bool settled{
+                            std::ranges::all_of(
+                                progress,
+                                [&](const PartitionProgress& partition)
+                                {
+                                    return
+                                        partition.change <= threshold ||
+                                        partition.passes >= nMaxSweeps;
+                                })};
+
+                        if (settled)
+                        {
+                            stopping = true;
+                        }
+                        else
+                        {
+                            std::this_thread::sleep_for(MONITOR_INTERVAL);
+                        }
+                    }
+                }};
+
+            // Every partition runs on its own thread until the monitor stops them all.
+            m_pool.forEach(
+                nPartitions,
+                [&](size_t partition)
+                {
+                    const auto first{static_cast<unsigned>(partition * nStates / nPartitions)};
+                    const auto last{
+                        static_cast<unsigned>((partition + 1) * nStates / nPartitions)};
+
+                    auto& own{progress[partition]};
+
+                    try
+                    {
+                        for (size_t pass{0};
+                            pass < nMaxSweeps && !stopping.load(std::memory_order_relaxed);
+                            ++pass)
+                        {
+                            double largest{0.};
+
+                            for (const auto state : std::views::iota(first, last))
+                            {
+                                double best{-std::numeric_limits<double>::infinity()};
+
+                                for (const auto action :
+                                    std::views::iota(0U, m_model.actions()))
+                                {
+                                    best = std::max(
+                                        best,
+                                        m_model.backupShared(state, action, value));
+                                }
+
+                                const std::atomic_ref shared{value[state]};
+
+                                largest = std::max(
+                                    largest,
+                                    std::abs(best - shared.load(std::memory_order_relaxed)));
+
+                                shared.store(best, std::memory_order_relaxed);
+                            }
+
+                            own.change = largest;
+                            own.passes = pass + 1;
+                        }
+                    }
+                    catch (...)
+                    {
+                        // Without this the other partitions would never stop.
+                        stopping = true;
+                        throw;
+                    }
+                });
+        }
+
+        const auto slowest{
+            std::ranges::min(
+                progress
+                | std::views::transform(
+                    [](const PartitionProgress& partition) { return partition.passes.load(); }))};
+
+        // Partitions saw each other's values part way through their passes, so their
+        // changes don't prove convergence until a synchronous sweep confirms them.
+        return evaluateOptimal(
+            std::move(value),
+            threshold,
+            std::max<size_t>(nMaxSweeps - std::min(slowest, nMaxSweeps), 1));
+    }
+
+    std::vector<unsigned> NativeEngine::improve(std::span<const double> value)
+    {
+        if (value.size() != m_model.states())
+        {
+            throw std::invalid_argument{"Need one value per state"};
+        }
+
+        std::vector<unsigned> policy(m_model.states());
+
+        forEachTile(
+            [&](size_t, unsigned first, unsigned last)
+            {
+                for (const auto state : std::views::iota(first, last))
+                {
+                    double best{-std::numeric_limits<double>::infinity()};
+
+                    for (const auto action : std::views::iota(0U, m_model.actions()))
+                    {
+                        const auto expected{m_model.backup(state, action, value)};
+
+                        if (expected > best)
+                        {
+                            best = expected;
+                            policy[state] = action;
+                        }
+                    }
+                }
+            });
+
+        return policy;
+    }
+
+    std::vector<double> NativeEngine::sweep(
+        const BackupFn& backupFn,
+        std::vector<double> value,
+        double threshold,
+        size_t nMaxSweeps)
+    {
+        if (value.size() != m_model.states())
+        {
+            throw std::invalid_argument{"Need one value per state"};
+        }
+
+        std::vector<double> next(value.size());
+        std::vector<double> tileChanges(tiles());
+
+        double change{std::numeric_limits<double>::max()};
+        for (size_t i{0}; i < nMaxSweeps && change > threshold; ++i)
+        {
+            forEachTile(
+                [&](size_t tile, unsigned first, unsigned last)
+                {
+                    double largest{0.};
+
+                    for (const auto state : std::views::iota(first, last))
+                    {
+                        next[state] = backupFn(state, value);
+                        largest = std::max(largest, std::abs(next[state] - value[state]));
+                    }
+
+                    tileChanges[tile] = largest;
+                });
+
+            change = std::ranges::max(tileChanges);
+
+            std::swap(value, next);
+        }
+
+        m_lastChange = change;
+
+        return value;
+    }
+
+    double NativeEngine::lastChange() const
+    {
+        return m_lastChange;
+    }
+
+    size_t NativeEngine::tiles() const
+    {
+        return (size_t{m_model.states()} + m_tileSize - 1) / m_tileSize;
+    }
+
+    void NativeEngine::forEachTile(
+        const std::function<void(size_t, unsigned, unsigned)>& tileFn)
+    {
+        m_pool.forEach(
+            tiles(),
+            [&](size_t tile)
+            {
+                const auto first{static_cast<unsigned>(tile * m_tileSize)};
+
+                tileFn(tile, first, std::min(first + m_tileSize, m_model.states()));
+            });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <ostream>
+#include <string>
+
+#include <arrayfire.h>
+
+#include "introRL/iteration/report.hpp"
+
+namespace irl::iteration
+{
+    namespace
+    {
+        /// <summary>
+        /// Formats a number as JSON.
+        /// </summary>
+        /// <param name="value">- The number to format.</param>
+        /// <returns>The number, or null if it isn't finite.</returns>
+        std::string jsonNumber(double value)
+        {
+            return std::isfinite(value) ? std::format("{}", value) : "null";
+        }
+    }
+
+    size_t deviceBytesInUse()
+    {
+        size_t allocatedBytes{};
+        size_t allocatedBuffers{};
+        size_t lockedBytes{};
+        size_t lockedBuffers{};
+
+        af::deviceMemInfo(&allocatedBytes, &allocatedBuffers, &lockedBytes, &lockedBuffers);
+
+        return lockedBytes;
+    }
+
+    std::string toJson(const IterationReport& report)
+    {
+        return std::format(
+            R"({{"iteration":{},"residual":{},"sweepSeconds":{},"expectedReturnSeconds":{},)"
+            R"("reductionSeconds":{},"deviceBytes":{},"policyChanges":{}}})",
+            report.iteration,
+            jsonNumber(report.residual),
+            jsonNumber(report.sweepSeconds),
+            jsonNumber(report.expectedReturnSeconds),
+            jsonNumber(report.reductionSeconds),
+            report.deviceBytes,
+            report.policyChanges ? std::format("{}", *report.policyChanges) : "null");
+    }
+
+    ReportFn jsonLines(std::ostream& out)
+    {
+        return
+            [&out](const IterationReport& report)
+            {
+                out << toJson(report) << '\n';
+            };
+    }
+}
\ No newline at end of file
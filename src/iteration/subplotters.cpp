@@ -88,7 +88,7 @@ namespace irl::iteration
         matplot::subplot(2, m.columns, size_t{m.columns} + m.column);
 
         matplot::image(
-            toMatrix<float>(reshape(stateValue.unwrap<iteration::StateValue>())));
+            toMatrix<float>(reshape(stateValue.unwrap<iteration::StateValue>().as(f32))));
 
         matplot::colorbar()
             .limits_mode_auto(true)
@@ -195,21 +195,27 @@ namespace irl::iteration
 
     void ValueIterationSubplotter::plot(const iteration::StateValue& stateValue)
     {
-        auto prePlot{toVector<double>(stateValue.unwrap<iteration::StateValue>())};
-
-        auto ax{valueAx()};
-
-        if (m.plotIterations.contains(m.count))
+        if (wants(m.count))
         {
-            auto stairs{matplot::stairs(ax, prePlot)};
+            auto stairs{
+                matplot::stairs(
+                    valueAx(),
+                    toVector<double>(stateValue.unwrap<iteration::StateValue>().as(f64)))};
             stairs->display_name(std::format("value iteration {}", m.count));
             stairs->stair_style(matplot::stair::stair_style::histogram);
         }
 
-        if (++m.count == 1)
-        {
-            matplot::hold(ax, matplot::on);
-        }
+        advance();
+    }
+
+    void ValueIterationSubplotter::skip()
+    {
+        advance();
+    }
+
+    bool ValueIterationSubplotter::wants(unsigned iteration) const
+    {
+        return m.plotIterations.contains(iteration);
     }
 
     void ValueIterationSubplotter::plot(const iteration::Policy& policy)
@@ -230,6 +236,14 @@ namespace irl::iteration
         matplot::show();
     }
 
+    void ValueIterationSubplotter::advance()
+    {
+        if (++m.count == 1)
+        {
+            matplot::hold(valueAx(), matplot::on);
+        }
+    }
+
     matplot::axes_handle ValueIterationSubplotter::policyAx() const
     {
         return matplot::subplot(2, m.columns, size_t{m.columns} + m.column);
@@ -0,0 +1,316 @@
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "introRL/mappedFile.hpp"
+
+namespace irl
+{
+    namespace
+    {
+        /// <summary>
+        /// Makes an exception describing the most recent failed system call.
+        /// </summary>
+        /// <param name="what">- What was being attempted.</param>
+        /// <param name="path">- The file it was being attempted on.</param>
+        /// <returns>An exception holding the most recent system error.</returns>
+        std::system_error lastError(std::string_view what, const std::filesystem::path& path)
+        {
+#ifdef _WIN32
+            const auto code{static_cast<int>(::GetLastError())};
+            const auto& category{std::system_category()};
+#else
+            const auto code{errno};
+            const auto& category{std::generic_category()};
+#endif
+            return std::system_error{
+                code,
+                category,
+                std::string{what} + " " + path.string()};
+        }
+    }
+
+    MappedFile::MappedFile(const std::filesystem::path& path, Access access) :
+        m_path{path},
+        m_access{access}
+    {
+        const bool readOnly{access == Access::read};
+
+#ifdef _WIN32
+        m_file = ::CreateFileW(
+            path.c_str(),
+            readOnly ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ,
+            nullptr,
+            readOnly ? OPEN_EXISTING : CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            m_file = nullptr;
+            throw lastError("Can't open", path);
+        }
+
+        LARGE_INTEGER size{};
+        if (!::GetFileSizeEx(m_file, &size))
+        {
+            const auto error{lastError("Can't size", path)};
+            close();
+            throw error;
+        }
+
+        m_size = static_cast<size_t>(size.QuadPart);
+#else
+        m_file = ::open(path.c_str(), readOnly ? O_RDONLY : O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+        if (m_file < 0)
+        {
+            throw lastError("Can't open", path);
+        }
+
+        struct stat status{};
+        if (::fstat(m_file, &status) != 0)
+        {
+            const auto error{lastError("Can't size", path)};
+            close();
+            throw error;
+        }
+
+        m_size = static_cast<size_t>(status.st_size);
+#endif
+
+        try
+        {
+            map();
+        }
+        catch (...)
+        {
+            close();
+            throw;
+        }
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept :
+        m_path{std::move(other.m_path)},
+        m_access{other.m_access},
+        m_size{std::exchange(other.m_size, 0)},
+        m_data{std::exchange(other.m_data, nullptr)},
+#ifdef _WIN32
+        m_file{std::exchange(other.m_file, nullptr)},
+        m_mapping{std::exchange(other.m_mapping, nullptr)}
+#else
+        m_file{std::exchange(other.m_file, -1)}
+#endif
+    {}
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+
+            m_path = std::move(other.m_path);
+            m_access = other.m_access;
+            m_size = std::exchange(other.m_size, 0);
+            m_data = std::exchange(other.m_data, nullptr);
+#ifdef _WIN32
+            m_file = std::exchange(other.m_file, nullptr);
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+#else
+            m_file = std::exchange(other.m_file, -1);
+#endif
+        }
+
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    void MappedFile::resize(size_t size)
+    {
+        if (m_access == Access::read)
+        {
+            throw std::runtime_error{"Can't resize a read only mapping"};
+        }
+
+        unmap();
+
+#ifdef _WIN32
+        LARGE_INTEGER end{};
+        end.QuadPart = static_cast<LONGLONG>(size);
+
+        if (!::SetFilePointerEx(m_file, end, nullptr, FILE_BEGIN) ||
+            !::SetEndOfFile(m_file))
+        {
+            throw lastError("Can't resize", m_path);
+        }
+#else
+        if (::ftruncate(m_file, static_cast<off_t>(size)) != 0)
+        {
+            throw lastError("Can't resize", m_path);
+        }
+#endif
+
+        m_size = size;
+
+        map();
+    }
+
+    void MappedFile::flush()
+    {
+        if (m_data == nullptr || m_access == Access::read)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        if (!::FlushViewOfFile(m_data, 0) || !::FlushFileBuffers(m_file))
+        {
+            throw lastError("Can't flush", m_path);
+        }
+#else
+        if (::msync(m_data, m_size, MS_SYNC) != 0)
+        {
+            throw lastError("Can't flush", m_path);
+        }
+#endif
+    }
+
+    const std::filesystem::path& MappedFile::path() const
+    {
+        return m_path;
+    }
+
+    size_t MappedFile::size() const
+    {
+        return m_size;
+    }
+
+    std::span<std::byte> MappedFile::bytes()
+    {
+        if (m_access == Access::read)
+        {
+            throw std::runtime_error{"Can't write to a read only mapping"};
+        }
+
+        return {m_data, m_size};
+    }
+
+    std::span<const std::byte> MappedFile::bytes() const
+    {
+        return {m_data, m_size};
+    }
+
+    void MappedFile::map()
+    {
+        if (m_size == 0)
+        {
+            return;
+        }
+
+        const bool readOnly{m_access == Access::read};
+
+#ifdef _WIN32
+        m_mapping = ::CreateFileMappingW(
+            m_file,
+            nullptr,
+            readOnly ? PAGE_READONLY : PAGE_READWRITE,
+            0,
+            0,
+            nullptr);
+
+        if (m_mapping == nullptr)
+        {
+            throw lastError("Can't map", m_path);
+        }
+
+        m_data = static_cast<std::byte*>(
+            ::MapViewOfFile(
+                m_mapping,
+                readOnly ? FILE_MAP_READ : FILE_MAP_WRITE,
+                0,
+                0,
+                m_size));
+
+        if (m_data == nullptr)
+        {
+            const auto error{lastError("Can't map", m_path)};
+            ::CloseHandle(m_mapping);
+            m_mapping = nullptr;
+            throw error;
+        }
+#else
+        void* data{
+            ::mmap(
+                nullptr,
+                m_size,
+                readOnly ? PROT_READ : PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                m_file,
+                0)};
+
+        if (data == MAP_FAILED)
+        {
+            throw lastError("Can't map", m_path);
+        }
+
+        m_data = static_cast<std::byte*>(data);
+#endif
+    }
+
+    void MappedFile::unmap()
+    {
+        if (m_data == nullptr)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        ::UnmapViewOfFile(m_data);
+        ::CloseHandle(m_mapping);
+        m_mapping = nullptr;
+#else
+        ::munmap(m_data, m_size);
+#endif
+
+        m_data = nullptr;
+    }
+
+    void MappedFile::close()
+    {
+        unmap();
+
+#ifdef _WIN32
+        if (m_file != nullptr)
+        {
+            ::CloseHandle(m_file);
+            m_file = nullptr;
+        }
+#else
+        if (m_file >= 0)
+        {
+            ::close(m_file);
+            m_file = -1;
+        }
+#endif
+    }
+}
\ No newline at end of file
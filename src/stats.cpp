@@ -1,16 +1,169 @@
+#include <algorithm>
 #include <cmath>
+#include <map>
+#include <mutex>
+#include <ranges>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <arrayfire.h>
 
+#include "introRL/afUtils.hpp"
 #include "introRL/stats.hpp"
 
 namespace irl
 {
+    namespace
+    {
+        std::mutex cacheMutex{};
+
+        /// <summary>
+        /// Returns the unfolded poisson probabilities of counts [0, size), extending a
+        /// per expectation cache with the recurrence p(k) = p(k - 1) * expectation / k.
+        /// </summary>
+        /// <param name="expectation">- The expected number of events per time.</param>
+        /// <param name="size">- The number of counts needed.</param>
+        /// <returns>At least size probabilities, starting from a count of zero.</returns>
+        const std::vector<double>& probabilities(unsigned expectation, size_t size)
+        {
+            static std::map<unsigned, std::vector<double>> cache{};
+
+            auto& result{cache[expectation]};
+
+            if (result.empty())
+            {
+                result.push_back(std::exp(-static_cast<double>(expectation)));
+            }
+
+            while (result.size() < size)
+            {
+                result.push_back(result.back() * expectation / result.size());
+            }
+
+            return result;
+        }
+
+        /// <summary>
+        /// A table of folded poisson probabilities, kept on the host so that caching it
+        /// doesn't hold device memory past ArrayFire's teardown at exit.
+        /// </summary>
+        struct FoldedTable
+        {
+            std::vector<float> probabilities;
+            double tailMass;
+        };
+
+        /// <summary>
+        /// Returns the cached table of folded poisson probabilities of some size.
+        /// </summary>
+        /// <param name="expectation">- The expected number of events per time.</param>
+        /// <param name="size">- The number of counts in the table.</param>
+        /// <returns>The folded probabilities and the mass folded into the last bucket.</returns>
+        const FoldedTable& foldedTable(unsigned expectation, unsigned size)
+        {
+            static std::map<std::pair<unsigned, unsigned>, FoldedTable> cache{};
+
+            const auto cached{cache.find({expectation, size})};
+            if (cached != cache.end())
+            {
+                return cached->second;
+            }
+
+            std::vector<float> folded(size);
+            double mass{0};
+
+            const auto& unfolded{probabilities(expectation, size)};
+            for (const auto count : std::views::iota(0U, size))
+            {
+                folded[count] = static_cast<float>(unfolded[count]);
+                mass += unfolded[count];
+            }
+
+            const auto tailMass{std::max(1. - mass, 0.)};
+            folded.back() += static_cast<float>(tailMass);
+
+            return cache.emplace(
+                std::pair{expectation, size},
+                FoldedTable{std::move(folded), tailMass}).first->second;
+        }
+    }
+
     af::array poisson(unsigned expectation, const af::array& samples)
     {
-        return
-            std::exp(-static_cast<int>(expectation)) *
-            af::pow(expectation, samples) /
-            af::factorial(samples);
+        const af::array counts{samples.as(f32)};
+
+        if (expectation == 0)
+        {
+            return (counts == 0).as(f32);
+        }
+
+        // Working in logs keeps large counts from overflowing pow and factorial.
+        return af::exp(
+            counts * static_cast<float>(std::log(expectation)) -
+            static_cast<float>(expectation) -
+            af::lgamma(counts + 1));
+    }
+
+    PoissonTable PoissonTable::fromTolerance(unsigned expectation, double tolerance)
+    {
+        if (tolerance <= 0)
+        {
+            throw std::invalid_argument{"Need a positive tail tolerance"};
+        }
+
+        unsigned size{1};
+        {
+            std::scoped_lock lock{cacheMutex};
+
+            double mass{0};
+            for (; ; ++size)
+            {
+                const auto probability{probabilities(expectation, size)[size - 1]};
+                mass += probability;
+
+                // Past the mode, a vanishing term means rounding has stalled the sum.
+                if (1. - mass <= tolerance || (size > expectation && probability == 0))
+                {
+                    break;
+                }
+            }
+        }
+
+        return fromSize(expectation, size);
+    }
+
+    PoissonTable PoissonTable::fromSize(unsigned expectation, unsigned size)
+    {
+        if (size == 0)
+        {
+            throw std::invalid_argument{"Need at least one count in a poisson table"};
+        }
+
+        std::scoped_lock lock{cacheMutex};
+
+        const auto& [probabilities, tailMass]{foldedTable(expectation, size)};
+
+        return PoissonTable{af::array{size, probabilities.data()}, tailMass};
     }
+
+    af::array PoissonTable::operator()(const af::array& samples) const
+    {
+        return at(m_probabilities, samples);
+    }
+
+    unsigned PoissonTable::size() const
+    {
+        return static_cast<unsigned>(m_probabilities.elements());
+    }
+
+    double PoissonTable::tailMass() const
+    {
+        return m_tailMass;
+    }
+
+    PoissonTable::PoissonTable(af::array probabilities, double tailMass) :
+        m_probabilities{std::move(probabilities)},
+        m_tailMass{tailMass}
+    {}
 }
\ No newline at end of file
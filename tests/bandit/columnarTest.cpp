@@ -0,0 +1,138 @@
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+
+#include <introRL/mappedFile.hpp>
+#include <introRL/types.hpp>
+#include <introRL/bandit/columnar.hpp>
+
+namespace irl::bandit
+{
+    TEST_CASE("bandit.columnar.ColumnarSink.keeps columns contiguous as it grows")
+    {
+        constexpr unsigned nSteps{3'000};
+
+        const auto path{ColumnarSink::temporaryPath()};
+        {
+            ColumnarSink testee{
+                path,
+                ParameterCount{2},
+                std::to_array<std::string_view>({"a", "b"})};
+
+            for (const auto step : std::views::iota(0U, nSteps))
+            {
+                const auto value{static_cast<float>(step)};
+
+                testee.append(
+                    std::to_array({
+                        std::vector{value, -value},
+                        std::vector{2 * value, -2 * value}}));
+            }
+
+            REQUIRE(testee.steps() == StepCount{nSteps});
+
+            const auto a{testee.columns(0)};
+            const auto b{testee.columns(1)};
+
+            REQUIRE(a.size() == 2);
+            REQUIRE(a[1].size() == nSteps);
+
+            REQUIRE(a[0][2'999] == 2'999.f);
+            REQUIRE(a[1][1'500] == -1'500.f);
+            REQUIRE(b[0][1'024] == 2'048.f);
+            REQUIRE(b[1][1] == -2.f);
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("bandit.columnar.ColumnarSink.writes a readable header")
+    {
+        const auto path{ColumnarSink::temporaryPath()};
+        {
+            ColumnarSink testee{
+                path,
+                ParameterCount{3},
+                std::to_array<std::string_view>({"rewards"}),
+                std::to_array({.1f, .2f, .3f})};
+
+            testee.append(std::to_array({std::vector{1.f, 2.f, 3.f}}));
+        }
+
+        {
+            const MappedFile file{path, MappedFile::Access::read};
+            const auto bytes{file.bytes()};
+
+            ColumnarHeader header{};
+            std::memcpy(&header, bytes.data(), sizeof(header));
+
+            REQUIRE(header.magic == ColumnarHeader::MAGIC);
+            REQUIRE(header.nParameters == 3);
+            REQUIRE(header.nKeys == 1);
+            REQUIRE(header.nSteps == 1);
+
+            const std::string_view key{
+                reinterpret_cast<const char*>(bytes.data() + sizeof(header))};
+
+            REQUIRE(key == "rewards");
+
+            std::array<float, 3> parameters{};
+            std::memcpy(
+                parameters.data(),
+                bytes.data() + sizeof(header) + header.keySize,
+                sizeof(parameters));
+
+            REQUIRE_THAT(
+                parameters,
+                Catch::Matchers::RangeEquals(std::to_array({.1f, .2f, .3f})));
+
+            std::array<float, 3> firstStep{};
+            for (auto&& [parameter, value] : std::views::enumerate(firstStep))
+            {
+                std::memcpy(
+                    &value,
+                    bytes.data() +
+                        header.dataOffset +
+                        parameter * header.capacity * sizeof(float),
+                    sizeof(float));
+            }
+
+            REQUIRE_THAT(
+                firstStep,
+                Catch::Matchers::RangeEquals(std::to_array({1.f, 2.f, 3.f})));
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("bandit.columnar.ColumnarSink.deletes unnamed files once unmapped")
+    {
+        std::filesystem::path path;
+        {
+            std::optional<Columns> view;
+            {
+                ColumnarSink testee{
+                    {},
+                    ParameterCount{1},
+                    std::to_array<std::string_view>({"rewards"})};
+
+                testee.append(std::to_array({std::vector{1.f}}));
+
+                path = testee.path();
+                view.emplace(testee.columns(0));
+            }
+
+            REQUIRE(std::filesystem::exists(path));
+            REQUIRE((*view)[0][0] == 1.f);
+        }
+
+        REQUIRE_FALSE(std::filesystem::exists(path));
+    }
+}
\ No newline at end of file
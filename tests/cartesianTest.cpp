@@ -1,4 +1,5 @@
 #include <array>
+#include <cmath>
 #include <ranges>
 
 #include <vector>
@@ -179,4 +180,42 @@ namespace irl
                         return (i / static_cast<unsigned>(std::pow(extent, 3))) % extent;
                     })));
     }
-}
+
+    TEST_CASE("cartesian.CartesianPower.slice.matches elements")
+    {
+        using Testee = CartesianPower<Extent{3}, Rank{4}, IndexAxis{1}, Index{2}>;
+
+        constexpr dim_t first{17};
+        constexpr dim_t count{40};
+
+        const auto slice{Testee::slice(first, count)};
+
+        REQUIRE(slice.dims() == af::dim4{1, count});
+        REQUIRE_THAT(
+            toVector<int>(slice),
+            Catch::Matchers::RangeEquals(
+                std::views::iota(first, first + count)
+                | std::views::transform(
+                    [](auto i)
+                    {
+                        return static_cast<int>((i / static_cast<dim_t>(std::pow(3, 2))) % 3);
+                    })));
+    }
+
+    TEST_CASE("cartesian.CartesianPower.of.indexes any linear indices")
+    {
+        using Testee = CartesianPower<Extent{3}, Rank{4}, IndexAxis{0}, Index{1}>;
+
+        const auto indices{std::to_array({0, 2, 3, 5, 80, 41})};
+
+        REQUIRE_THAT(
+            toVector<int>(Testee::of(toArrayFire(indices))),
+            Catch::Matchers::RangeEquals(
+                indices
+                | std::views::transform(
+                    [](auto i)
+                    {
+                        return (i / static_cast<int>(std::pow(3, 1))) % 3;
+                    })));
+    }
+}
\ No newline at end of file
@@ -1,11 +1,21 @@
+#include <array>
+#include <cmath>
 #include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <arrayfire.h>
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/trompeloeil.hpp>
 
+#include <introRL/afUtils.hpp>
 #include <introRL/types.hpp>
 #include <introRL/iteration/algorithm.hpp>
+#include <introRL/iteration/model.hpp>
+#include <introRL/iteration/native.hpp>
+#include <introRL/iteration/report.hpp>
 #include <introRL/iteration/types.hpp>
 
 namespace irl::iteration
@@ -17,6 +27,82 @@ namespace irl::iteration
         MAKE_MOCK1(plot, void(const StateValue&));
     };
 
+    namespace
+    {
+        constexpr unsigned CHAIN_LENGTH{10};
+
+        /// <summary>
+        /// The expected return of a chain where every state but the last pays 1 and moves
+        /// to the next state at a discount of .5, and the last state pays 1 and ends.
+        /// </summary>
+        af::array chainReturn(
+            const StateIndices& stateIndices,
+            const ActionIndices&,
+            const StateValue& stateValue)
+        {
+            const auto& states{stateIndices.unwrap<StateIndices>()};
+            const auto& value{stateValue.unwrap<StateValue>()};
+
+            const auto last{af::constant(CHAIN_LENGTH - 1, states.dims(), u32)};
+
+            return af::select(
+                states == CHAIN_LENGTH - 1,
+                af::constant(1., states.dims(), f64),
+                1. + .5 * at(value, af::min(states + 1, last)));
+        }
+
+        /// <summary>
+        /// The expected return of a walk over evenly spaced points on [0, 1], where each
+        /// point pays its position and then moves to either neighbour at a discount of
+        /// .95, staying put instead of stepping off either end.
+        /// </summary>
+        af::array walkReturn(const ActionIndices&, const StateValue& stateValue)
+        {
+            const auto& value{stateValue.unwrap<StateValue>()};
+            const auto n{value.dims(0)};
+
+            const af::array left{af::join(0, value(0), value(af::seq(0, n - 2)))};
+            const af::array right{af::join(0, value(af::seq(1, n - 1)), value(n - 1))};
+
+            return
+                af::range(af::dim4{n}, 0, f64) / (n - 1) +
+                .95 * (left + right) / 2;
+        }
+
+        /// <summary>
+        /// Every state in the chain.
+        /// </summary>
+        af::array chainStates()
+        {
+            return af::range(af::dim4{CHAIN_LENGTH}, 0, u32);
+        }
+
+        /// <summary>
+        /// A model of the chain where action 0 stays put, paying 1 only in the last state,
+        /// while action 1 moves one state along the chain for nothing, at a discount of .9.
+        /// </summary>
+        TransitionModel chainModel()
+        {
+            return TransitionModel{
+                ActionCount{2},
+                StateCount{CHAIN_LENGTH},
+                .9,
+                [](unsigned action)
+                {
+                    const af::array states{chainStates()};
+
+                    return Transitions{
+                        .from{states},
+                        .to{action == 0 ? states : af::min(states + 1, CHAIN_LENGTH - 1)},
+                        .probability{af::constant(1.f, CHAIN_LENGTH)},
+                        .reward{
+                            action == 0
+                                ? (states == CHAIN_LENGTH - 1).as(f32)
+                                : af::constant(0.f, CHAIN_LENGTH)}};
+                }};
+        }
+    }
+
     TEST_CASE("iteration.algorithm.PolicyIteration.plots at least once")
     {
         PolicyIteration testee{
@@ -36,6 +122,129 @@ namespace irl::iteration
         testee.iterate(plotter);
     }
 
+    TEST_CASE("iteration.algorithm.PolicyIteration.finds the optimal policy with bounded sweeps")
+    {
+        // Action a pays a and stays put at a discount of .9, so the last action is best.
+        PolicyIteration testee{
+            ActionCount{3},
+            StateCount{3},
+            [](const ActionIndices& actionIndices, const StateValue& stateValue)
+            {
+                return
+                    actionIndices.unwrap<ActionIndices>().as(f32) +
+                    .9 * stateValue.unwrap<StateValue>();
+            },
+            [] {},
+            PolicyEvaluation{.sweeps{2}, .growth{2.}}};
+
+        af::array lastPolicy{};
+        af::array lastValue{};
+
+        MockPlotter plotter{};
+        ALLOW_CALL(plotter, plot(ANY(const Policy&)))
+            .LR_SIDE_EFFECT(lastPolicy = _1.unwrap<Policy>());
+        ALLOW_CALL(plotter, plot(ANY(const StateValue&)))
+            .LR_SIDE_EFFECT(lastValue = _1.unwrap<StateValue>());
+
+        testee.iterate(plotter);
+
+        REQUIRE(af::allTrue<bool>(lastPolicy == 2));
+        REQUIRE(af::max<double>(af::abs(lastValue - 20.)) < 1e-4);
+    }
+
+    TEST_CASE("iteration.algorithm.PolicyIteration.improves incrementally")
+    {
+        // Every state but the last should move.
+        const auto model{chainModel()};
+
+        const auto optimalPolicy{
+            [&](const PolicyImprovement& policyImprovement)
+            {
+                const PolicyIteration testee{
+                    model,
+                    [] {},
+                    PolicyEvaluation{.method{EvaluationMethod::iterative}},
+                    policyImprovement};
+
+                af::array lastPolicy{};
+
+                MockPlotter plotter{};
+                ALLOW_CALL(plotter, plot(ANY(const Policy&)))
+                    .LR_SIDE_EFFECT(lastPolicy = _1.unwrap<Policy>());
+                ALLOW_CALL(plotter, plot(ANY(const StateValue&)));
+
+                testee.iterate(plotter);
+
+                return lastPolicy;
+            }};
+
+        const auto full{optimalPolicy({})};
+        const auto incremental{optimalPolicy({.incremental{true}})};
+
+        REQUIRE(af::allTrue<bool>(full == incremental));
+        REQUIRE(af::sum<unsigned>(full) == CHAIN_LENGTH - 1);
+    }
+
+    TEST_CASE("iteration.algorithm.PolicyIteration.evaluates model policies iteratively")
+    {
+        const auto model{chainModel()};
+        const PolicyIteration testee{
+            model,
+            [] {},
+            PolicyEvaluation{
+                .method{EvaluationMethod::iterative},
+                .precision{Precision::full}}};
+
+        af::array lastPolicy{};
+        af::array lastValue{};
+
+        MockPlotter plotter{};
+        ALLOW_CALL(plotter, plot(ANY(const Policy&)))
+            .LR_SIDE_EFFECT(lastPolicy = _1.unwrap<Policy>());
+        ALLOW_CALL(plotter, plot(ANY(const StateValue&)))
+            .LR_SIDE_EFFECT(lastValue = _1.unwrap<StateValue>());
+
+        testee.iterate(plotter);
+
+        REQUIRE(
+            af::max<double>(
+                af::abs(lastValue - model.solve(Policy{lastPolicy}).unwrap<StateValue>()))
+            < 1e-5);
+    }
+
+    TEST_CASE("iteration.algorithm.PolicyIteration.evaluates model policies natively")
+    {
+        const auto model{chainModel()};
+
+        const auto optimal{
+            [&](EvaluationMethod method)
+            {
+                const PolicyIteration testee{
+                    model,
+                    [] {},
+                    PolicyEvaluation{.method{method}, .precision{Precision::full}}};
+
+                af::array lastPolicy{};
+                af::array lastValue{};
+
+                MockPlotter plotter{};
+                ALLOW_CALL(plotter, plot(ANY(const Policy&)))
+                    .LR_SIDE_EFFECT(lastPolicy = _1.unwrap<Policy>());
+                ALLOW_CALL(plotter, plot(ANY(const StateValue&)))
+                    .LR_SIDE_EFFECT(lastValue = _1.unwrap<StateValue>());
+
+                testee.iterate(plotter);
+
+                return std::pair{lastPolicy, lastValue};
+            }};
+
+        const auto [iterativePolicy, iterativeValue]{optimal(EvaluationMethod::iterative)};
+        const auto [nativePolicy, nativeValue]{optimal(EvaluationMethod::native)};
+
+        REQUIRE(af::allTrue<bool>(nativePolicy == iterativePolicy));
+        REQUIRE(af::max<double>(af::abs(nativeValue - iterativeValue)) < 1e-5);
+    }
+
     TEST_CASE("iteration.algorithm.ValueIteration.plots at least once")
     {
         ValueIteration testee{ActionCount{2}, StateCount{3}};
@@ -53,4 +262,729 @@ namespace irl::iteration
             },
             plotter);
     }
+
+    TEST_CASE("iteration.algorithm.ValueIteration.sweeps natively to the optimal policy")
+    {
+        const auto model{chainModel()};
+        const ValueIteration testee{model.actions(), model.states()};
+
+        const auto sweepNatively{
+            [&](bool asynchronous)
+            {
+                af::array lastPolicy{};
+                af::array lastValue{};
+
+                MockPlotter plotter{};
+                REQUIRE_CALL(plotter, plot(ANY(const Policy&)))
+                    .LR_SIDE_EFFECT(lastPolicy = _1.unwrap<Policy>());
+                REQUIRE_CALL(plotter, plot(ANY(const StateValue&)))
+                    .LR_SIDE_EFFECT(lastValue = _1.unwrap<StateValue>());
+
+                testee.iterate(
+                    NativeSweep{
+                        .engine{
+                            std::make_shared<native::NativeEngine>(native::NativeModel{model})},
+                        .asynchronous{asynchronous}},
+                    plotter);
+
+                REQUIRE(af::sum<unsigned>(lastPolicy) == CHAIN_LENGTH - 1);
+                REQUIRE(
+                    af::max<double>(
+                        af::abs(
+                            lastValue -
+                            model.solve(Policy{lastPolicy}).unwrap<StateValue>().as(f64)))
+                    < 1e-5);
+            }};
+
+        sweepNatively(false);
+        sweepNatively(true);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluate.overshoots by less than its check interval")
+    {
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., CHAIN_LENGTH, f64)};
+        const auto expectedReturn{
+            [](const ActionIndices& actionIndices, const StateValue& stateValue)
+            {
+                return chainReturn(StateIndices{chainStates()}, actionIndices, stateValue);
+            }};
+        const auto reduce{
+            [](const af::array& expectedReturn)
+            {
+                return StateValue{af::max(expectedReturn, 2)};
+            }};
+
+        unsigned everySweeps{0};
+        const auto every{
+            evaluate(
+                actions,
+                initial,
+                expectedReturn,
+                reduce,
+                [&](const StateValue&) { ++everySweeps; })};
+
+        constexpr unsigned checkInterval{4};
+
+        unsigned intervalSweeps{0};
+        const auto interval{
+            evaluate(
+                actions,
+                initial,
+                expectedReturn,
+                reduce,
+                [&](const StateValue&) { ++intervalSweeps; },
+                1e-9,
+                1e3,
+                checkInterval)};
+
+        REQUIRE(
+            af::max<double>(
+                af::abs(every.unwrap<StateValue>() - interval.unwrap<StateValue>()))
+            < 1e-8);
+
+        REQUIRE(intervalSweeps % checkInterval == 0);
+        REQUIRE(intervalSweeps >= everySweeps);
+        REQUIRE(intervalSweeps < everySweeps + checkInterval);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluate.reports every sweep")
+    {
+        unsigned nSweeps{0};
+        std::vector<IterationReport> reports{};
+
+        const auto value{
+            evaluate(
+                ActionIndices{af::constant(0, af::dim4{1, 1, 1}, u32)},
+                StateValue{af::constant(0., CHAIN_LENGTH, f64)},
+                [](const ActionIndices& actionIndices, const StateValue& stateValue)
+                {
+                    return chainReturn(StateIndices{chainStates()}, actionIndices, stateValue);
+                },
+                [](const af::array& expectedReturn)
+                {
+                    return StateValue{af::max(expectedReturn, 2)};
+                },
+                [&](const StateValue&) { ++nSweeps; },
+                1e-9,
+                1e3,
+                4,
+                {},
+                [&](const IterationReport& report) { reports.push_back(report); })};
+
+        REQUIRE(reports.size() == nSweeps);
+        REQUIRE(reports.back().iteration == nSweeps - 1);
+        REQUIRE(reports.front().residual > reports.back().residual);
+        REQUIRE(reports.back().residual <= 1e-9);
+        REQUIRE(reports.back().sweepSeconds >= reports.back().expectedReturnSeconds);
+        REQUIRE(!reports.back().policyChanges);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluate.accelerates slow fixed points")
+    {
+        // Every state pays 1 and stays put at a discount of .9, so is worth 10.
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., 3, f64)};
+        const auto expectedReturn{
+            [](const ActionIndices&, const StateValue& stateValue)
+            {
+                return 1. + .9 * stateValue.unwrap<StateValue>();
+            }};
+        const auto reduce{
+            [](const af::array& expectedReturn)
+            {
+                return StateValue{expectedReturn};
+            }};
+
+        const auto sweepsWith{
+            [&](const Acceleration& acceleration)
+            {
+                unsigned sweeps{0};
+                const auto result{
+                    evaluate(
+                        actions,
+                        initial,
+                        expectedReturn,
+                        reduce,
+                        [&](const StateValue&) { ++sweeps; },
+                        1e-9,
+                        1e3,
+                        1,
+                        acceleration)};
+
+                REQUIRE(af::max<double>(af::abs(result.unwrap<StateValue>() - 10.)) < 1e-6);
+
+                return sweeps;
+            }};
+
+        const auto plain{sweepsWith({})};
+
+        REQUIRE(
+            sweepsWith({.method{AccelerationMethod::overRelaxation}, .relaxation{5.}})
+            < plain / 4);
+        REQUIRE(sweepsWith({.method{AccelerationMethod::anderson}, .depth{3}}) < plain / 10);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluate.converges each variant independently")
+    {
+        // Every state pays 1 and stays put, at a discount of .5 in the first variant and
+        // .9 in the second, so is worth 2 in the first and 10 in the second.
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., 3, 2, f64)};
+        const af::array discounts{af::moddims(af::array{.5, .9}, af::dim4{1, 2})};
+
+        unsigned sweeps{0};
+        af::array firstVariant{};
+        const auto result{
+            evaluate(
+                actions,
+                initial,
+                [&](const ActionIndices&, const StateValue& stateValue)
+                {
+                    return 1. + discounts * stateValue.unwrap<StateValue>();
+                },
+                [](const af::array& expectedReturn)
+                {
+                    return StateValue{expectedReturn};
+                },
+                [&](const StateValue& stateValue)
+                {
+                    // The first variant converges long before the second.
+                    if (++sweeps == 100)
+                    {
+                        firstVariant = stateValue.unwrap<StateValue>()(af::span, 0).copy();
+                    }
+                })};
+
+        const auto& value{result.unwrap<StateValue>()};
+
+        REQUIRE(value.dims() == af::dim4{3, 2});
+        REQUIRE(af::max<double>(af::abs(value(af::span, 0) - 2.)) < 1e-8);
+        REQUIRE(af::max<double>(af::abs(value(af::span, 1) - 10.)) < 1e-6);
+        REQUIRE(sweeps > 100);
+        REQUIRE(af::allTrue<bool>(firstVariant == value(af::span, 0)));
+    }
+
+    TEST_CASE("iteration.algorithm.evaluate.accelerates each variant independently")
+    {
+        // Every state pays 1 and stays put, at a discount of .5 in the first variant and
+        // .9 in the second. Each variant is a linear map, which its own Anderson weights
+        // solve within a few sweeps, but which weights shared between them wouldn't.
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const af::array discounts{af::moddims(af::array{.5, .9}, af::dim4{1, 2})};
+
+        unsigned sweeps{0};
+        const auto result{
+            evaluate(
+                actions,
+                StateValue{af::constant(0., 3, 2, f64)},
+                [&](const ActionIndices&, const StateValue& stateValue)
+                {
+                    return 1. + discounts * stateValue.unwrap<StateValue>();
+                },
+                [](const af::array& expectedReturn)
+                {
+                    return StateValue{expectedReturn};
+                },
+                [&](const StateValue&) { ++sweeps; },
+                1e-9,
+                1e3,
+                1,
+                {.method{AccelerationMethod::anderson}, .depth{3}})};
+
+        const auto& value{result.unwrap<StateValue>()};
+
+        REQUIRE(af::max<double>(af::abs(value(af::span, 0) - 2.)) < 1e-8);
+        REQUIRE(af::max<double>(af::abs(value(af::span, 1) - 10.)) < 1e-8);
+        REQUIRE(sweeps < 10);
+    }
+
+    TEST_CASE("iteration.algorithm.estimateAt.polishes mixed precision in double precision")
+    {
+        // Every state pays 1 and stays put at a discount of .9, so is worth 10.
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., 3, f32)};
+
+        const auto estimate{
+            [&](Precision precision, unsigned& doubleSweeps)
+            {
+                return estimateAt(
+                    precision,
+                    initial,
+                    1e-9,
+                    [&](const StateValue& initialValue, double threshold)
+                    {
+                        return evaluate(
+                            actions,
+                            initialValue,
+                            [](const ActionIndices&, const StateValue& stateValue)
+                            {
+                                return 1. + .9 * stateValue.unwrap<StateValue>();
+                            },
+                            [](const af::array& expectedReturn)
+                            {
+                                return StateValue{expectedReturn};
+                            },
+                            [&](const StateValue& stateValue)
+                            {
+                                doubleSweeps += stateValue.unwrap<StateValue>().type() == f64;
+                            },
+                            threshold);
+                    });
+            }};
+
+        unsigned fullSweeps{0};
+        const auto full{estimate(Precision::full, fullSweeps)};
+
+        unsigned mixedSweeps{0};
+        const auto mixed{estimate(Precision::mixed, mixedSweeps)};
+
+        REQUIRE(mixed.unwrap<StateValue>().type() == f64);
+        REQUIRE(
+            af::max<double>(
+                af::abs(full.unwrap<StateValue>() - mixed.unwrap<StateValue>()))
+            < 1e-7);
+
+        REQUIRE(mixedSweeps < fullSweeps);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluateInPlace.matches evaluate in fewer sweeps")
+    {
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., CHAIN_LENGTH, f64)};
+        const auto reduce{
+            [](const af::array& expectedReturn)
+            {
+                return StateValue{af::max(expectedReturn, 2)};
+            }};
+
+        unsigned jacobiSweeps{0};
+        const auto jacobi{
+            evaluate(
+                actions,
+                initial,
+                [](const ActionIndices& actionIndices, const StateValue& stateValue)
+                {
+                    return chainReturn(
+                        StateIndices{chainStates()},
+                        actionIndices,
+                        stateValue);
+                },
+                reduce,
+                [&](const StateValue&) { ++jacobiSweeps; })};
+
+        unsigned inPlaceSweeps{0};
+        const auto inPlace{
+            evaluateInPlace(
+                actions,
+                initial,
+                chainReturn,
+                reduce,
+                SweepOrder{.order{af::flip(chainStates(), 0)}, .blockSize{2}},
+                [&](const StateValue&) { ++inPlaceSweeps; })};
+
+        REQUIRE(
+            af::max<double>(
+                af::abs(jacobi.unwrap<StateValue>() - inPlace.unwrap<StateValue>()))
+            < 1e-8);
+
+        REQUIRE(inPlaceSweeps < jacobiSweeps);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluateInPlace.converges each variant independently")
+    {
+        // Every state pays 1 and stays put, at a discount of .5 in the first variant and
+        // .9 in the second, so is worth 2 in the first and 10 in the second.
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const af::array discounts{af::moddims(af::array{.5, .9}, af::dim4{1, 2})};
+
+        unsigned sweeps{0};
+        af::array firstVariant{};
+        const auto result{
+            evaluateInPlace(
+                actions,
+                StateValue{af::constant(0., 3, 2, f64)},
+                [&](
+                    const StateIndices& stateIndices,
+                    const ActionIndices&,
+                    const StateValue& stateValue)
+                {
+                    const auto& states{stateIndices.unwrap<StateIndices>()};
+
+                    return 1. + af::tile(discounts, states.elements()) *
+                        stateValue.unwrap<StateValue>()(states, af::span);
+                },
+                [](const af::array& expectedReturn)
+                {
+                    return StateValue{expectedReturn};
+                },
+                SweepOrder{.order{af::range(af::dim4{3}, 0, u32)}},
+                [&](const StateValue& stateValue)
+                {
+                    // The first variant converges long before the second.
+                    if (++sweeps == 100)
+                    {
+                        firstVariant = stateValue.unwrap<StateValue>()(af::span, 0).copy();
+                    }
+                })};
+
+        const auto& value{result.unwrap<StateValue>()};
+
+        REQUIRE(af::max<double>(af::abs(value(af::span, 0) - 2.)) < 1e-8);
+        REQUIRE(af::max<double>(af::abs(value(af::span, 1) - 10.)) < 1e-6);
+        REQUIRE(sweeps > 100);
+        REQUIRE(af::allTrue<bool>(firstVariant == value(af::span, 0)));
+    }
+
+    TEST_CASE("iteration.algorithm.evaluatePrioritised.matches evaluate")
+    {
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., CHAIN_LENGTH, f64)};
+        const auto reduce{
+            [](const af::array& expectedReturn)
+            {
+                return StateValue{af::max(expectedReturn, 2)};
+            }};
+
+        const auto jacobi{
+            evaluate(
+                actions,
+                initial,
+                [](const ActionIndices& actionIndices, const StateValue& stateValue)
+                {
+                    return chainReturn(
+                        StateIndices{chainStates()},
+                        actionIndices,
+                        stateValue);
+                },
+                reduce)};
+
+        // Each state reads the value of the next at a discount of .5.
+        const TransitionGraph graph{
+            af::sparseConvertTo(
+                af::sparse(
+                    CHAIN_LENGTH,
+                    CHAIN_LENGTH,
+                    af::constant(.5, CHAIN_LENGTH - 1, f64),
+                    af::range(af::dim4{CHAIN_LENGTH - 1}, 0, s32),
+                    af::range(af::dim4{CHAIN_LENGTH - 1}, 0, s32) + 1,
+                    AF_STORAGE_COO),
+                AF_STORAGE_CSR)};
+
+        const auto prioritised{
+            evaluatePrioritised(
+                actions,
+                initial,
+                chainReturn,
+                reduce,
+                PrioritySweep{.transitionGraph{graph}, .batchSize{3}})};
+
+        REQUIRE(
+            af::max<double>(
+                af::abs(jacobi.unwrap<StateValue>() - prioritised.unwrap<StateValue>()))
+            < 1e-8);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluatePrioritised.adds up small disturbances")
+    {
+        // State 0 is worth a fifth of the sum of four successors, which are each worth 1.
+        constexpr unsigned nStates{5};
+        constexpr double threshold{1e-3};
+        constexpr double disturbance{2e-3};
+
+        const auto stateReturn{
+            [](const StateIndices& stateIndices, const ActionIndices&, const StateValue& stateValue)
+            {
+                const auto& states{stateIndices.unwrap<StateIndices>()};
+                const auto& value{stateValue.unwrap<StateValue>()};
+
+                return af::select(
+                    states == 0,
+                    af::tile(.2 * af::sum(value(af::seq(1, nStates - 1))), states.dims()),
+                    af::constant(1., states.dims(), f64));
+            }};
+
+        // Each successor starts off by more than the threshold, but its backup only moves
+        // state 0 by a fifth of that, which is less than the threshold.
+        af::array initial{af::constant(1. - disturbance, nStates, f64)};
+        initial(0) = .2 * 4 * (1. - disturbance);
+
+        const TransitionGraph graph{
+            af::sparseConvertTo(
+                af::sparse(
+                    nStates,
+                    nStates,
+                    af::constant(.2, nStates - 1, f64),
+                    af::constant(0, nStates - 1, s32),
+                    af::range(af::dim4{nStates - 1}, 0, s32) + 1,
+                    AF_STORAGE_COO),
+                AF_STORAGE_CSR)};
+
+        const auto value{
+            evaluatePrioritised(
+                ActionIndices{af::constant(0, af::dim4{1, 1, 1}, u32)},
+                StateValue{initial},
+                stateReturn,
+                [](const af::array& expectedReturn)
+                {
+                    return StateValue{af::max(expectedReturn, 2)};
+                },
+                PrioritySweep{.transitionGraph{graph}, .batchSize{1}},
+                [](const StateValue&) {},
+                threshold)};
+
+        REQUIRE(std::abs(af::flat(value.unwrap<StateValue>())(0).scalar<double>() - .8) < 1e-9);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluateEliminating.matches evaluate with fewer actions")
+    {
+        // Action a pays a and stays put at a discount of .9, so the last action is best.
+        constexpr unsigned nActions{4};
+
+        const ActionIndices actions{af::range(af::dim4{1, 1, nActions}, 2, u32)};
+        const StateValue initial{af::constant(0., CHAIN_LENGTH, f64)};
+
+        std::vector<dim_t> nBackedUp{};
+        const auto expectedReturn{
+            [&](const ActionIndices& actionIndices, const StateValue& stateValue)
+            {
+                const auto& indices{actionIndices.unwrap<ActionIndices>()};
+                const auto& value{stateValue.unwrap<StateValue>()};
+
+                nBackedUp.push_back(indices.dims(2));
+
+                return
+                    af::tile(indices.as(f64), CHAIN_LENGTH / indices.dims(0)) +
+                    .9 * af::tile(value, 1, 1, indices.dims(2));
+            }};
+
+        const auto expected{
+            evaluate(
+                actions,
+                initial,
+                expectedReturn,
+                [](const af::array& expectedReturn)
+                {
+                    return StateValue{af::max(expectedReturn, 2)};
+                })};
+
+        nBackedUp.clear();
+
+        const auto eliminated{
+            evaluateEliminating(
+                actions,
+                initial,
+                expectedReturn,
+                ActionElimination{.discount{.9}})};
+
+        REQUIRE(
+            af::max<double>(
+                af::abs(expected.unwrap<StateValue>() - eliminated.unwrap<StateValue>()))
+            < 1e-8);
+
+        REQUIRE(nBackedUp.front() == nActions);
+        REQUIRE(nBackedUp.back() == 1);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluateEliminating.converges each variant independently")
+    {
+        // Action a pays a and stays put, at a discount of .5 in the first variant and .9
+        // in the second, so the last action is worth 2 in the first and 10 in the second.
+        constexpr unsigned nStates{3};
+        constexpr unsigned nActions{2};
+
+        const af::array discounts{af::moddims(af::array{.5, .9}, af::dim4{1, 2})};
+
+        unsigned sweeps{0};
+        af::array firstVariant{};
+        const auto result{
+            evaluateEliminating(
+                ActionIndices{af::range(af::dim4{1, 1, nActions}, 2, u32)},
+                StateValue{af::constant(0., nStates, 2, f64)},
+                [&](const ActionIndices& actionIndices, const StateValue& stateValue)
+                {
+                    const auto& indices{actionIndices.unwrap<ActionIndices>()};
+                    const auto nKept{indices.dims(2)};
+
+                    return
+                        af::tile(indices.as(f64), nStates / indices.dims(0), 2) +
+                        af::tile(discounts, nStates, 1, nKept) *
+                        af::tile(stateValue.unwrap<StateValue>(), 1, 1, nKept);
+                },
+                ActionElimination{.discount{.9}},
+                [&](const StateValue& stateValue)
+                {
+                    // The first variant converges long before the second.
+                    if (++sweeps == 100)
+                    {
+                        firstVariant = stateValue.unwrap<StateValue>()(af::span, 0).copy();
+                    }
+                })};
+
+        const auto& value{result.unwrap<StateValue>()};
+
+        REQUIRE(af::max<double>(af::abs(value(af::span, 0) - 2.)) < 1e-8);
+        REQUIRE(af::max<double>(af::abs(value(af::span, 1) - 10.)) < 1e-6);
+        REQUIRE(sweeps > 100);
+        REQUIRE(af::allTrue<bool>(firstVariant == value(af::span, 0)));
+    }
+
+    TEST_CASE("iteration.algorithm.evaluateRealTime.only backs up reachable states")
+    {
+        constexpr unsigned firstReachable{5};
+
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., CHAIN_LENGTH, f64)};
+
+        const auto expected{
+            evaluate(
+                actions,
+                initial,
+                [](const ActionIndices& actionIndices, const StateValue& stateValue)
+                {
+                    return chainReturn(StateIndices{chainStates()}, actionIndices, stateValue);
+                },
+                [](const af::array& expectedReturn)
+                {
+                    return StateValue{af::max(expectedReturn, 2)};
+                })};
+
+        const auto testee{
+            evaluateRealTime(
+                actions,
+                initial,
+                chainReturn,
+                RealTimeSearch{
+                    .startStates{af::constant(firstReachable, 1, u32)},
+                    .successorFn{
+                        [](const StateIndices& stateIndices, const ActionIndices&)
+                        {
+                            // The last state ends the chain.
+                            const auto& states{stateIndices.unwrap<StateIndices>()};
+
+                            return StateIndices{states + 1};
+                        }},
+                    .batchSize{4},
+                    .horizon{CHAIN_LENGTH}})};
+
+        const auto& value{testee.unwrap<StateValue>()};
+
+        REQUIRE(af::allTrue<bool>(value(af::seq(0, firstReachable - 1)) == 0));
+        REQUIRE(
+            af::max<double>(
+                af::abs(
+                    value(af::seq(firstReachable, CHAIN_LENGTH - 1)) -
+                    expected.unwrap<StateValue>()(af::seq(firstReachable, CHAIN_LENGTH - 1))))
+            < 1e-8);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluateRealTime.stops after a run of quiet trials")
+    {
+        constexpr unsigned quietTrials{5};
+
+        // Trials start in the last state, which pays 1 and ends, so only the first trial
+        // changes anything.
+        unsigned trials{0};
+        const auto testee{
+            evaluateRealTime(
+                ActionIndices{af::constant(0, af::dim4{1, 1, 1}, u32)},
+                StateValue{af::constant(0., CHAIN_LENGTH, f64)},
+                chainReturn,
+                RealTimeSearch{
+                    .startStates{af::constant(CHAIN_LENGTH - 1, 1, u32)},
+                    .successorFn{
+                        [](const StateIndices& stateIndices, const ActionIndices&)
+                        {
+                            return StateIndices{stateIndices.unwrap<StateIndices>() + 1};
+                        }},
+                    .batchSize{1},
+                    .quietTrials{quietTrials}},
+                [&](const StateValue&) { ++trials; })};
+
+        REQUIRE(trials == 1 + quietTrials);
+        REQUIRE(af::flat(testee.unwrap<StateValue>())(CHAIN_LENGTH - 1).scalar<double>() == 1.);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluatePrioritised.rejects batches of variants")
+    {
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const StateValue initial{af::constant(0., CHAIN_LENGTH, 2, f64)};
+        const auto reduce{
+            [](const af::array& expectedReturn)
+            {
+                return StateValue{af::max(expectedReturn, 2)};
+            }};
+
+        REQUIRE_THROWS_AS(
+            evaluatePrioritised(
+                actions,
+                initial,
+                chainReturn,
+                reduce,
+                PrioritySweep{
+                    .transitionGraph{
+                        af::sparse(af::identity(CHAIN_LENGTH, CHAIN_LENGTH, f64))}}),
+            std::invalid_argument);
+        REQUIRE_THROWS_AS(
+            evaluateRealTime(
+                actions,
+                initial,
+                chainReturn,
+                RealTimeSearch{
+                    .startStates{af::constant(0, 1, u32)},
+                    .successorFn{
+                        [](const StateIndices& stateIndices, const ActionIndices&)
+                        {
+                            return stateIndices;
+                        }}}),
+            std::invalid_argument);
+    }
+
+    TEST_CASE("iteration.algorithm.evaluateMultigrid.matches evaluate in fewer fine sweeps")
+    {
+        constexpr dim_t fine{65};
+
+        const ActionIndices actions{af::constant(0, af::dim4{1, 1, 1}, u32)};
+        const auto reduce{
+            [](const af::array& expectedReturn)
+            {
+                return StateValue{af::max(expectedReturn, 2)};
+            }};
+
+        unsigned coldSweeps{0};
+        const auto cold{
+            evaluate(
+                actions,
+                StateValue{af::constant(0., fine, f64)},
+                walkReturn,
+                reduce,
+                [&](const StateValue&) { ++coldSweeps; },
+                1e-6)};
+
+        const auto levels{
+            std::to_array<GridLevel>({
+                {.shape{9}, .actionIndices{actions}, .expectedReturnFn{walkReturn}},
+                {.shape{17}, .actionIndices{actions}, .expectedReturnFn{walkReturn}},
+                {.shape{fine}, .actionIndices{actions}, .expectedReturnFn{walkReturn}}})};
+
+        unsigned fineSweeps{0};
+        const auto multigrid{
+            evaluateMultigrid(
+                levels,
+                StateValue{af::constant(0., 9, f64)},
+                reduce,
+                [&](const StateValue& stateValue)
+                {
+                    fineSweeps += stateValue.unwrap<StateValue>().dims(0) == fine;
+                },
+                1e-6)};
+
+        REQUIRE(multigrid.unwrap<StateValue>().dims(0) == fine);
+        REQUIRE(
+            af::max<double>(
+                af::abs(cold.unwrap<StateValue>() - multigrid.unwrap<StateValue>()))
+            < 1e-4);
+
+        REQUIRE(fineSweeps < coldSweeps);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <format>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include <arrayfire.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+
+#include <introRL/afUtils.hpp>
+#include <introRL/iteration/asyncSubplotter.hpp>
+#include <introRL/iteration/types.hpp>
+
+namespace irl::iteration
+{
+    namespace
+    {
+        /// <summary>
+        /// A subplotter that records what it was asked to do.
+        /// </summary>
+        class RecordingSubplotter
+        {
+        public:
+            explicit RecordingSubplotter(std::vector<std::string>& events) :
+                m_events{&events}
+            {}
+
+            void plot(const Policy& policy)
+            {
+                m_events->push_back(
+                    std::format("policy {}", toVector<unsigned>(policy.unwrap<Policy>())[0]));
+            }
+
+            void plot(const StateValue& stateValue)
+            {
+                m_events->push_back(
+                    std::format(
+                        "value {}",
+                        toVector<float>(stateValue.unwrap<StateValue>())[0]));
+            }
+
+            void skip()
+            {
+                m_events->push_back("skip");
+            }
+
+            void show()
+            {
+                m_events->push_back("show");
+            }
+
+        private:
+            std::vector<std::string>* m_events;
+        };
+
+        /// <summary>
+        /// A recording subplotter that only wants every other state value estimate.
+        /// </summary>
+        class SelectiveSubplotter : public RecordingSubplotter
+        {
+        public:
+            using RecordingSubplotter::RecordingSubplotter;
+
+            [[nodiscard]] bool wants(unsigned iteration) const
+            {
+                return iteration % 2 == 0;
+            }
+        };
+    }
+
+    TEST_CASE("iteration.asyncSubplotter.AsyncSubplotter.plots snapshots in order")
+    {
+        std::vector<std::string> events{};
+
+        {
+            AsyncSubplotter testee{
+                RecordingSubplotter{events},
+                [](unsigned iteration) { return iteration != 1; }};
+
+            af::array value{af::constant(0, 3)};
+
+            for (const auto i : {1.f, 2.f, 3.f})
+            {
+                value(af::span) = i;
+                testee.plot(StateValue{value});
+            }
+
+            testee.run([](RecordingSubplotter& subplotter) { subplotter.skip(); });
+            testee.plot(Policy{af::constant(7, 3, u32)});
+
+            value(af::span) = 4.f;
+            testee.plot(StateValue{value});
+
+            testee.show();
+        }
+
+        REQUIRE_THAT(
+            events,
+            Catch::Matchers::RangeEquals(
+                std::vector<std::string>{
+                    "value 1", "skip", "value 3", "skip", "policy 7", "value 4", "show"}));
+    }
+
+    TEST_CASE("iteration.asyncSubplotter.AsyncSubplotter.defaults to what the subplotter wants")
+    {
+        std::vector<std::string> events{};
+
+        {
+            AsyncSubplotter testee{SelectiveSubplotter{events}};
+
+            af::array value{af::constant(0, 3)};
+
+            for (const auto i : {1.f, 2.f, 3.f})
+            {
+                value(af::span) = i;
+                testee.plot(StateValue{value});
+            }
+
+            testee.show();
+        }
+
+        REQUIRE_THAT(
+            events,
+            Catch::Matchers::RangeEquals(
+                std::vector<std::string>{"value 1", "skip", "value 3", "show"}));
+    }
+
+    TEST_CASE("iteration.asyncSubplotter.AsyncSubplotter.waits for room in a full queue")
+    {
+        std::vector<std::string> events{};
+        std::vector<std::string> expected{};
+
+        {
+            AsyncSubplotter testee{RecordingSubplotter{events}, {}, 1};
+
+            af::array value{af::constant(0, 3)};
+
+            for (const auto i : std::views::iota(0, 20))
+            {
+                value(af::span) = static_cast<float>(i);
+                testee.plot(StateValue{value});
+                expected.push_back(std::format("value {}", i));
+            }
+
+            testee.show();
+            expected.push_back("show");
+        }
+
+        REQUIRE_THAT(events, Catch::Matchers::RangeEquals(expected));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+#include <arrayfire.h>
+#include <catch2/catch_test_macros.hpp>
+
+#include <introRL/afUtils.hpp>
+#include <introRL/types.hpp>
+#include <introRL/iteration/model.hpp>
+#include <introRL/iteration/types.hpp>
+
+namespace irl::iteration
+{
+    namespace
+    {
+        /// <summary>
+        /// A model where action 0 stays put, and action 1 moves from state 0 to either
+        /// state with even odds (through a repeated coordinate) or from state 1 to state 0.
+        /// </summary>
+        TransitionModel twoStateModel()
+        {
+            return TransitionModel{
+                ActionCount{2},
+                StateCount{2},
+                .5,
+                [](unsigned action)
+                {
+                    if (action == 0)
+                    {
+                        return Transitions{
+                            .from{toArrayFire(std::to_array({0U, 1U}))},
+                            .to{toArrayFire(std::to_array({0U, 1U}))},
+                            .probability{toArrayFire(std::to_array({1.f, 1.f}))},
+                            .reward{toArrayFire(std::to_array({1.f, 2.f}))}};
+                    }
+
+                    return Transitions{
+                        .from{toArrayFire(std::to_array({0U, 0U, 0U, 1U}))},
+                        .to{toArrayFire(std::to_array({1U, 1U, 0U, 0U}))},
+                        .probability{toArrayFire(std::to_array({.25f, .25f, .5f, 1.f}))},
+                        .reward{toArrayFire(std::to_array({0.f, 3.f}))}};
+                }};
+        }
+
+        /// <summary>
+        /// Returns the largest absolute difference between two arrays.
+        /// </summary>
+        double largestError(const af::array& actual, const af::array& expected)
+        {
+            return af::max<double>(af::abs(af::flat(actual) - af::flat(expected)));
+        }
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.backs up shared actions")
+    {
+        const auto testee{twoStateModel()};
+
+        const auto result{
+            testee.expectedReturn(
+                ActionIndices{af::range(af::dim4{1, 1, 2}, 2, u32)},
+                StateValue{toArrayFire(std::to_array({2.f, 4.f}))})};
+
+        REQUIRE(result.dims() == af::dim4{2, 1, 2});
+        REQUIRE(
+            largestError(result, toArrayFire(std::to_array({2.f, 4.f, 1.5f, 4.f})))
+            < 1e-6);
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.backs up one action per state")
+    {
+        const auto testee{twoStateModel()};
+
+        const auto result{
+            testee.expectedReturn(
+                ActionIndices{toArrayFire(std::to_array({1U, 0U}))},
+                StateValue{toArrayFire(std::to_array({2.f, 4.f}))})};
+
+        REQUIRE(result.dims() == af::dim4{2});
+        REQUIRE(largestError(result, toArrayFire(std::to_array({1.5f, 4.f}))) < 1e-6);
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.backs up chosen states")
+    {
+        const auto testee{twoStateModel()};
+
+        const auto result{
+            testee.stateReturn(
+                StateIndices{toArrayFire(std::to_array({1U, 0U}))},
+                ActionIndices{af::range(af::dim4{1, 1, 2}, 2, u32)},
+                StateValue{toArrayFire(std::to_array({2.f, 4.f}))})};
+
+        REQUIRE(result.dims() == af::dim4{2, 1, 2});
+        REQUIRE(
+            largestError(result, toArrayFire(std::to_array({4.f, 2.f, 4.f, 1.5f})))
+            < 1e-6);
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.samples successors")
+    {
+        const auto testee{twoStateModel()};
+
+        const auto certain{
+            testee.sample(
+                StateIndices{toArrayFire(std::to_array({0U, 1U, 1U}))},
+                ActionIndices{toArrayFire(std::to_array({0U, 0U, 1U}))})};
+
+        REQUIRE(
+            largestError(
+                certain.unwrap<StateIndices>().as(f32),
+                toArrayFire(std::to_array({0.f, 1.f, 0.f})))
+            == 0);
+
+        constexpr unsigned nSamples{10'000};
+
+        const auto even{
+            testee.sample(
+                StateIndices{af::constant(0, nSamples, u32)},
+                ActionIndices{af::constant(1, nSamples, u32)})};
+
+        REQUIRE(std::abs(af::mean<double>(even.unwrap<StateIndices>().as(f64)) - .5) < .05);
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.solves policies exactly")
+    {
+        const auto testee{twoStateModel()};
+
+        const auto result{testee.solve(Policy{toArrayFire(std::to_array({1U, 0U}))})};
+
+        REQUIRE(
+            largestError(
+                result.unwrap<StateValue>(),
+                toArrayFire(std::to_array({4. / 3., 4.})))
+            < 1e-9);
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.bounds dependencies between states")
+    {
+        const auto testee{twoStateModel()};
+
+        const auto graph{af::dense(testee.transitionGraph().unwrap<TransitionGraph>())};
+
+        REQUIRE(
+            largestError(graph, toArrayFire(std::to_array({.5f, .5f, .25f, .5f})))
+            < 1e-6);
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.loads what it saves")
+    {
+        const auto path{std::filesystem::temp_directory_path() / "introRL-modelTest.model"};
+        const auto hash{parameterHash(std::to_array({.5, 2.}))};
+
+        twoStateModel().save(path, hash);
+
+        REQUIRE_FALSE(TransitionModel::load(path, hash + 1));
+
+        const auto loaded{TransitionModel::load(path, hash)};
+
+        REQUIRE(loaded);
+        REQUIRE(loaded->discount() == .5);
+
+        const ActionIndices actions{af::range(af::dim4{1, 1, 2}, 2, u32)};
+        const StateValue value{toArrayFire(std::to_array({2.f, 4.f}))};
+
+        REQUIRE(
+            largestError(
+                loaded->expectedReturn(actions, value),
+                twoStateModel().expectedReturn(actions, value))
+            < 1e-6);
+        REQUIRE(
+            largestError(
+                af::dense(loaded->transitionGraph().unwrap<TransitionGraph>()),
+                af::dense(twoStateModel().transitionGraph().unwrap<TransitionGraph>()))
+            < 1e-6);
+
+        std::filesystem::remove(path);
+
+        REQUIRE_FALSE(TransitionModel::load(path, hash));
+    }
+
+    TEST_CASE("iteration.model.TransitionModel.rejects damaged files")
+    {
+        const auto path{std::filesystem::temp_directory_path() / "introRL-modelTest.model"};
+        const auto hash{parameterHash(std::to_array({.5, 2.}))};
+
+        twoStateModel().save(path, hash);
+
+        ModelHeader header{};
+        {
+            std::ifstream file{path, std::ios::binary};
+            file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        }
+
+        SECTION("truncated")
+        {
+            std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        }
+
+        SECTION("with entries the offsets don't end at")
+        {
+            ++header.nEntries;
+
+            std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        SECTION("with offsets outside the file")
+        {
+            header.columnsOffset = std::filesystem::file_size(path);
+
+            std::fstream file{path, std::ios::binary | std::ios::in | std::ios::out};
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        REQUIRE_FALSE(TransitionModel::load(path, hash));
+
+        std::filesystem::remove(path);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <ranges>
+#include <vector>
+
+#include <arrayfire.h>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_floating_point.hpp>
+#include <catch2/matchers/catch_matchers_range_equals.hpp>
+
+#include <introRL/afUtils.hpp>
+#include <introRL/types.hpp>
+#include <introRL/iteration/model.hpp>
+#include <introRL/iteration/native.hpp>
+#include <introRL/iteration/types.hpp>
+
+namespace irl::iteration::native
+{
+    namespace
+    {
+        constexpr unsigned CHAIN_LENGTH{100};
+
+        /// <summary>
+        /// A chain where action 0 stays put, paying 1 only in the last state, while
+        /// action 1 moves one state along the chain for nothing.
+        /// </summary>
+        TransitionModel chainModel()
+        {
+            return TransitionModel{
+                ActionCount{2},
+                StateCount{CHAIN_LENGTH},
+                .9,
+                [](unsigned action)
+                {
+                    const af::array states{af::range(af::dim4{CHAIN_LENGTH}, 0, u32)};
+
+                    return Transitions{
+                        .from{states},
+                        .to{action == 0 ? states : af::min(states + 1, CHAIN_LENGTH - 1)},
+                        .probability{af::constant(1.f, CHAIN_LENGTH)},
+                        .reward{
+                            action == 0
+                                ? (states == CHAIN_LENGTH - 1).as(f32)
+                                : af::constant(0.f, CHAIN_LENGTH)}};
+                }};
+        }
+    }
+
+    TEST_CASE("iteration.native.WorkerPool.runs every task once")
+    {
+        WorkerPool testee{4};
+
+        std::vector<unsigned> counts(1'000);
+        testee.forEach(counts.size(), [&](size_t i) { ++counts[i]; });
+
+        REQUIRE(std::ranges::all_of(counts, [](unsigned count) { return count == 1; }));
+    }
+
+    TEST_CASE("iteration.native.NativeEngine.evaluates policies like the model")
+    {
+        const auto model{chainModel()};
+        NativeEngine testee{NativeModel{model}, 4, 16};
+
+        std::vector<unsigned> policy(CHAIN_LENGTH, 1);
+        policy.back() = 0;
+
+        const auto value{
+            testee.evaluate(policy, std::vector<double>(CHAIN_LENGTH), 1e-12, 1e5)};
+        const auto expected{
+            toVector<double>(model.solve(Policy{toArrayFire(policy)}).unwrap<StateValue>())};
+
+        for (const auto [actual, exact] : std::views::zip(value, expected))
+        {
+            REQUIRE_THAT(actual, Catch::Matchers::WithinAbs(exact, 1e-9));
+        }
+    }
+
+    TEST_CASE("iteration.native.NativeEngine.relaxes asynchronously to the optimal value")
+    {
+        NativeEngine testee{NativeModel{chainModel()}, 4, 16};
+
+        const auto expected{
+            testee.evaluateOptimal(std::vector<double>(CHAIN_LENGTH), 1e-12, 1e5)};
+        const auto value{
+            testee.evaluateOptimalAsynchronously(std::vector<double>(CHAIN_LENGTH), 1e-12, 1e5)};
+
+        for (const auto [actual, exact] : std::views::zip(value, expected))
+        {
+            REQUIRE_THAT(actual, Catch::Matchers::WithinAbs(exact, 1e-9));
+        }
+    }
+
+    TEST_CASE("iteration.native.NativeEngine.improves to the optimal policy")
+    {
+        NativeEngine testee{NativeModel{chainModel()}, 4, 16};
+
+        const auto policy{
+            testee.improve(
+                testee.evaluateOptimal(std::vector<double>(CHAIN_LENGTH), 1e-12, 1e5))};
+
+        std::vector<unsigned> expected(CHAIN_LENGTH, 1);
+        expected.back() = 0;
+
+        REQUIRE_THAT(policy, Catch::Matchers::RangeEquals(expected));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include <limits>
+#include <sstream>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <introRL/iteration/report.hpp>
+
+namespace irl::iteration
+{
+    TEST_CASE("iteration.report.toJson.writes one object per report")
+    {
+        const IterationReport report{
+            .iteration{3},
+            .residual{.5},
+            .sweepSeconds{.25},
+            .expectedReturnSeconds{.125},
+            .reductionSeconds{std::numeric_limits<double>::infinity()},
+            .deviceBytes{1'024},
+            .policyChanges{7}};
+
+        REQUIRE(
+            toJson(report) ==
+            R"({"iteration":3,"residual":0.5,"sweepSeconds":0.25,"expectedReturnSeconds":0.125,)"
+            R"("reductionSeconds":null,"deviceBytes":1024,"policyChanges":7})");
+    }
+
+    TEST_CASE("iteration.report.jsonLines.writes a line per report")
+    {
+        std::ostringstream out{};
+        const auto testee{jsonLines(out)};
+
+        testee(IterationReport{});
+        testee(IterationReport{.iteration{1}});
+
+        REQUIRE(
+            out.str() ==
+            R"({"iteration":0,"residual":0,"sweepSeconds":0,"expectedReturnSeconds":0,)"
+            R"("reductionSeconds":0,"deviceBytes":0,"policyChanges":null})" "\n"
+            R"({"iteration":1,"residual":0,"sweepSeconds":0,"expectedReturnSeconds":0,)"
+            R"("reductionSeconds":0,"deviceBytes":0,"policyChanges":null})" "\n");
+    }
+}
\ No newline at end of file
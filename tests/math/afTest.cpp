@@ -25,6 +25,35 @@ namespace irl::math
             Catch::Matchers::RangeEquals(std::to_array({1, 2, 3, 4})));
     }
 
+    TEST_CASE("math.af.argMax.breaks ties with the lowest index")
+    {
+        const af::array m{af::moddims(af::array{1.f, 3.f, 3.f, 0.f, 2.f, 2.f}, af::dim4{3, 2})};
+
+        REQUIRE_THAT(
+            toVector<unsigned>(argMax<0>(m)),
+            Catch::Matchers::RangeEquals(std::to_array({1, 1})));
+    }
+
+    TEST_CASE("math.af.argMax.reduces the higher dimensions")
+    {
+        const af::array m{
+            af::moddims(
+                af::array{
+                    0.f, 5.f,
+                    4.f, 1.f,
+                    4.f, 5.f,
+                    2.f, 1.f},
+                af::dim4{1, 2, 2, 2})};
+
+        REQUIRE_THAT(
+            toVector<unsigned>(argMax<2>(m)),
+            Catch::Matchers::RangeEquals(std::to_array({1, 0, 0, 0})));
+
+        REQUIRE_THAT(
+            toVector<unsigned>(argMax<3>(m)),
+            Catch::Matchers::RangeEquals(std::to_array({1, 0, 0, 0})));
+    }
+
     TEST_CASE("math.af.power.handles normal values")
     {
         REQUIRE(power(2, 3) == 8);
@@ -42,6 +42,43 @@ namespace irl
                 }));
     }
 
+    TEST_CASE("stats.poisson.accepts counts of any size")
+    {
+        auto testee{toVector<float>(poisson(3, toArrayFire(std::to_array({-1.f, 200.f, 3.f}))))};
+
+        REQUIRE(testee[0] == 0);
+        REQUIRE(testee[1] < 1e-30f);
+        REQUIRE(std::abs(testee[2] - .2240f) < 1e-4f);
+    }
+
+    TEST_CASE("stats.PoissonTable.folds its tail into the last bucket")
+    {
+        const auto testee{PoissonTable::fromSize(2, 5)};
+
+        REQUIRE(testee.size() == 5);
+        REQUIRE_THAT(testee.tailMass(), Catch::Matchers::WithinAbs(.0527, .0001));
+
+        const auto probabilities{toVector<float>(testee(af::range(af::dim4{5}, 0, s32)))};
+
+        REQUIRE_THAT(
+            probabilities,
+            Catch::Matchers::RangeEquals(
+                std::to_array({.1353f, .2707f, .2707f, .1804f, .1429f}),
+                [](float l, float r)
+                {
+                    float d{std::abs(l - r)};
+                    return d < 0.0001;
+                }));
+    }
+
+    TEST_CASE("stats.PoissonTable.picks the smallest size within tolerance")
+    {
+        const auto testee{PoissonTable::fromTolerance(3, 1e-6)};
+
+        REQUIRE(testee.tailMass() <= 1e-6);
+        REQUIRE(PoissonTable::fromSize(3, testee.size() - 1).tailMass() > 1e-6);
+    }
+
     TEST_CASE("stats.sample.returns different values")
     {
         std::mt19937 generator{0};